@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+#ifndef MESSAGES_TYPES
+#define MESSAGES_TYPES 4
+#endif
+
+#ifndef MSG_READY
+#define MSG_READY 1
+#endif
+
+#ifndef MSG_ITEM
+#define MSG_ITEM 2
+#endif
+
+#ifndef MSG_ROOM
+#define MSG_ROOM 3
+#endif
+
+size_t items = 200000;
+unsigned long work_nsec = 1000;
+
+role_t role_for_consumer;
+actor_id_t consumer;
+
+size_t sent;
+size_t full;
+size_t consumed;
+uint64_t start;
+uint64_t elapsed;
+bench_latencies_t latencies;
+
+/* Sends until the mailbox of the consumer is full, and goes on once it is
+ * notified that there is room again. */
+void produce() {
+    while (sent < items) {
+        int err = send_message_async(consumer, bench_stamped_message(MSG_ITEM),
+                                     MSG_ROOM);
+        if (err == -3) {
+            full++;
+            return;
+        }
+        else if (err) {
+            fprintf(stderr, "Sending message to an actor failed: %d\n", err);
+        }
+        sent++;
+    }
+
+    message_t go_die = {
+            .message_type = MSG_GODIE,
+            .nbytes = 0,
+            .data = NULL
+    };
+    send_or_report(consumer, go_die);
+    send_or_report(actor_id_self(), go_die);
+}
+
+void on_hello_producer(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+    UNUSED(data);
+
+    message_t spawn = {
+            .message_type = MSG_SPAWN,
+            .nbytes = sizeof(role_t),
+            .data = &role_for_consumer
+    };
+    send_or_report(actor_id_self(), spawn);
+}
+
+void on_ready(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+
+    consumer = (actor_id_t) data;
+    start = bench_now_nsec();
+    produce();
+}
+
+void on_room(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+    UNUSED(data);
+
+    produce();
+}
+
+void on_hello_consumer(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+
+    message_t ready = {
+            .message_type = MSG_READY,
+            .nbytes = sizeof(actor_id_t),
+            .data = (void *) actor_id_self()
+    };
+    send_or_report((actor_id_t) data, ready);
+}
+
+/* Slower than the producer, so that its mailbox stays full. */
+void on_item(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+
+    bench_record_since(&latencies, data);
+
+    uint64_t busy_until = bench_now_nsec() + work_nsec;
+    while (bench_now_nsec() < busy_until) {
+    }
+
+    if (++consumed == items) {
+        elapsed = bench_now_nsec() - start;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        items = strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2) {
+        work_nsec = strtoul(argv[2], NULL, 10);
+    }
+
+    act_t acts_for_producer[] = {on_hello_producer, on_ready, NULL, on_room};
+    role_t role_for_producer = {
+            .nprompts = MESSAGES_TYPES,
+            .prompts = acts_for_producer
+    };
+    act_t acts_for_consumer[] = {on_hello_consumer, NULL, on_item, NULL};
+    role_for_consumer = (role_t) {
+            .nprompts = MESSAGES_TYPES,
+            .prompts = acts_for_consumer
+    };
+
+    actor_id_t producer;
+    int err;
+    if ((err = create_or_report(&producer, &role_for_producer))) {
+        return err;
+    }
+    actor_system_join(producer);
+
+    char parameters[96];
+    snprintf(parameters, sizeof(parameters), "items=%zu work_nsec=%lu full=%zu",
+             items, work_nsec, full);
+    bench_report("backpressure", parameters, (double) consumed, elapsed, &latencies);
+
+    return 0;
+}
@@ -0,0 +1,179 @@
+#include "bench.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+uint64_t bench_now_nsec(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+}
+
+size_t bench_bucket(uint64_t nsec) {
+    if (nsec < (1u << BENCH_SUB_BUCKET_BITS)) {
+        return nsec;
+    }
+
+    int log = 63 - __builtin_clzll(nsec);
+    int shift = log - BENCH_SUB_BUCKET_BITS;
+
+    return ((size_t) (shift + 1) << BENCH_SUB_BUCKET_BITS)
+           | ((nsec >> shift) & ((1u << BENCH_SUB_BUCKET_BITS) - 1));
+}
+
+uint64_t bench_bucket_upper_bound(size_t bucket) {
+    if (bucket < (1u << BENCH_SUB_BUCKET_BITS)) {
+        return bucket;
+    }
+
+    int shift = (int) (bucket >> BENCH_SUB_BUCKET_BITS) - 1;
+    uint64_t mantissa = (1u << BENCH_SUB_BUCKET_BITS)
+                        | (bucket & ((1u << BENCH_SUB_BUCKET_BITS) - 1));
+
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void bench_latencies_record(bench_latencies_t *latencies, uint64_t nsec) {
+    atomic_fetch_add_explicit(&latencies->buckets[bench_bucket(nsec)], 1,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&latencies->count, 1, memory_order_relaxed);
+
+    unsigned long long max = atomic_load_explicit(&latencies->max,
+                                                  memory_order_relaxed);
+    while (nsec > max && !atomic_compare_exchange_weak_explicit(
+            &latencies->max, &max, nsec, memory_order_relaxed,
+            memory_order_relaxed)) {
+    }
+}
+
+uint64_t bench_latencies_percentile(bench_latencies_t *latencies, double fraction) {
+    unsigned long long count = atomic_load(&latencies->count);
+    unsigned long long max = atomic_load(&latencies->max);
+    unsigned long long rank = (unsigned long long) (fraction * (double) count);
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    unsigned long long seen = 0;
+    for (size_t i = 0; i < BENCH_BUCKETS && count > 0; i++) {
+        seen += atomic_load(&latencies->buckets[i]);
+        if (seen >= rank) {
+            uint64_t upper_bound = bench_bucket_upper_bound(i);
+
+            return upper_bound < max ? upper_bound : max;
+        }
+    }
+
+    return max;
+}
+
+message_t bench_stamped_message(message_type_t message_type) {
+    message_t message = {0};
+    uint64_t now = bench_now_nsec();
+    message_inline(&message, message_type, &now, sizeof(now));
+
+    return message;
+}
+
+void bench_record_since(bench_latencies_t *latencies, void *data) {
+    uint64_t stamp;
+    memcpy(&stamp, data, sizeof(stamp));
+    bench_latencies_record(latencies, bench_now_nsec() - stamp);
+}
+
+static const struct {
+    const char *name;
+    uint32_t type;
+    uint64_t config;
+} bench_counter_events[BENCH_COUNTERS] = {
+        {"cache_references", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES},
+        {"cache_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {"l1d_read_misses", PERF_TYPE_HW_CACHE,
+                PERF_COUNT_HW_CACHE_L1D
+                | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)}
+};
+
+void bench_counters_open(bench_counters_t *counters) {
+    for (size_t i = 0; i < BENCH_COUNTERS; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = bench_counter_events[i].type;
+        attr.config = bench_counter_events[i].config;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        counters->fds[i] = (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+}
+
+void bench_counters_close(bench_counters_t *counters, double messages,
+                          char *buffer, size_t size) {
+    long long values[BENCH_COUNTERS];
+    for (size_t i = 0; i < BENCH_COUNTERS; i++) {
+        uint64_t value;
+        values[i] = -1;
+        if (counters->fds[i] >= 0) {
+            if (read(counters->fds[i], &value, sizeof(value)) == sizeof(value)) {
+                values[i] = (long long) value;
+            }
+            close(counters->fds[i]);
+        }
+    }
+
+    size_t length = 0;
+    for (size_t i = 0; i < BENCH_COUNTERS && length < size; i++) {
+        length += (size_t) snprintf(buffer + length, size - length, "%s=%lld ",
+                                    bench_counter_events[i].name, values[i]);
+    }
+    if (length < size) {
+        snprintf(buffer + length, size - length, "cache_misses_per_msg=%.2f",
+                 values[1] >= 0 && messages > 0 ? (double) values[1] / messages : -1.0);
+    }
+}
+
+void send_or_report(actor_id_t actor, message_t message) {
+    int err;
+    if ((err = send_message(actor, message))) {
+        fprintf(stderr, "Sending message to an actor failed: %d\n", err);
+    }
+}
+
+int create_or_report(actor_id_t *actor, role_t *role) {
+    int err;
+    if ((err = actor_system_create(actor, role))) {
+        fprintf(stderr, "Actor system creation failed: %d, %s\n",
+                errno, strerror(errno));
+    }
+
+    return err;
+}
+
+void bench_report(const char *name, const char *parameters, double messages,
+                  uint64_t elapsed_nsec, bench_latencies_t *latencies) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    double seconds = (double) elapsed_nsec / 1e9;
+    printf("bench=%s %s messages=%.0f seconds=%.3f msgs_per_sec=%.0f "
+           "latency_samples=%llu p50_usec=%.1f p90_usec=%.1f p99_usec=%.1f "
+           "p999_usec=%.1f max_usec=%.1f max_rss_kb=%ld\n",
+           name, parameters, messages, seconds,
+           seconds > 0 ? messages / seconds : 0.0,
+           atomic_load(&latencies->count),
+           (double) bench_latencies_percentile(latencies, 0.5) / 1e3,
+           (double) bench_latencies_percentile(latencies, 0.9) / 1e3,
+           (double) bench_latencies_percentile(latencies, 0.99) / 1e3,
+           (double) bench_latencies_percentile(latencies, 0.999) / 1e3,
+           (double) atomic_load(&latencies->max) / 1e3,
+           usage.ru_maxrss);
+}
@@ -0,0 +1,63 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "cacti.h"
+
+#define UNUSED(x) (void)(x)
+
+#define BENCH_SUB_BUCKET_BITS 4
+#define BENCH_BUCKETS (64 << BENCH_SUB_BUCKET_BITS)
+
+/* Latencies in nanoseconds, in buckets 1/16 of a power of two wide. Any
+ * thread may record into it. */
+typedef struct bench_latencies {
+    _Atomic unsigned long long count;
+    _Atomic unsigned long long max;
+    _Atomic unsigned long long buckets[BENCH_BUCKETS];
+} bench_latencies_t;
+
+uint64_t bench_now_nsec(void);
+
+void bench_latencies_record(bench_latencies_t *latencies, uint64_t nsec);
+
+/* Upper bound of the bucket holding the given fraction of latencies. */
+uint64_t bench_latencies_percentile(bench_latencies_t *latencies, double fraction);
+
+/* Builds an inline message carrying the time it was built at, which its
+ * handler passes to bench_record_since along with its data. */
+message_t bench_stamped_message(message_type_t message_type);
+
+void bench_record_since(bench_latencies_t *latencies, void *data);
+
+#define BENCH_COUNTERS 3
+
+/* Hardware cache counters of the process, which threads created after
+ * bench_counters_open inherit, the workers of a system created then
+ * included. Counters the kernel does not provide stay unavailable. */
+typedef struct bench_counters {
+    int fds[BENCH_COUNTERS];
+} bench_counters_t;
+
+void bench_counters_open(bench_counters_t *counters);
+
+/* Formats the counters, and cache misses per message, as key=value pairs
+ * for the parameters of bench_report, with -1 for unavailable ones, and
+ * closes them. Threads are counted only once they have exited. */
+void bench_counters_close(bench_counters_t *counters, double messages,
+                          char *buffer, size_t size);
+
+void send_or_report(actor_id_t actor, message_t message);
+
+int create_or_report(actor_id_t *actor, role_t *role);
+
+/* Prints a single line of key=value pairs: the name of the benchmark, the
+ * parameters, the throughput, latency percentiles and the peak RSS. The
+ * spawn benchmarks count spawned actors as messages. */
+void bench_report(const char *name, const char *parameters, double messages,
+                  uint64_t elapsed_nsec, bench_latencies_t *latencies);
+
+#endif
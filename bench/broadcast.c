@@ -0,0 +1,208 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+
+#ifndef MESSAGES_TYPES
+#define MESSAGES_TYPES 4
+#endif
+
+#ifndef MSG_READY
+#define MSG_READY 1
+#endif
+
+#ifndef MSG_TICK
+#define MSG_TICK 2
+#endif
+
+#ifndef MSG_DONE
+#define MSG_DONE 3
+#endif
+
+size_t members = 4096;
+size_t ticks = 200;
+bool use_group = true;
+
+role_t role_for_member;
+actor_id_t root;
+actor_id_t *member_ids;
+group_id_t group;
+
+size_t spawned;
+size_t ready;
+_Atomic size_t done;
+uint64_t start, end;
+bench_latencies_t latencies;
+
+/* Every tick carries the time it was sent at, so that the latency runs
+ * from the broadcast to each member handling it. */
+void send_ticks() {
+    start = bench_now_nsec();
+
+    for (size_t i = 0; i < ticks; i++) {
+        message_t tick = bench_stamped_message(MSG_TICK);
+        if (use_group) {
+            int delivered = broadcast_message(group, tick);
+            if (delivered != (int) members) {
+                fprintf(stderr, "Broadcast reached %d members\n", delivered);
+            }
+        }
+        else {
+            for (size_t j = 0; j < members; j++) {
+                send_or_report(member_ids[j], tick);
+            }
+        }
+    }
+}
+
+/* Keeps the spawn requests the root sends to itself below the mailbox
+ * limit. */
+void spawn_members(size_t n) {
+    message_t spawn = {
+            .message_type = MSG_SPAWN,
+            .nbytes = sizeof(role_t),
+            .data = &role_for_member
+    };
+
+    for (size_t i = 0; i < n && spawned < members; i++, spawned++) {
+        send_or_report(actor_id_self(), spawn);
+    }
+}
+
+void on_hello_root(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+    UNUSED(data);
+
+    group = actor_group("broadcast");
+    spawn_members(ACTOR_QUEUE_LIMIT / 4);
+}
+
+void on_ready(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+
+    member_ids[ready++] = (actor_id_t) data;
+    if (ready == members) {
+        send_ticks();
+    }
+    else {
+        spawn_members(1);
+    }
+}
+
+void on_done(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+    UNUSED(data);
+
+    end = bench_now_nsec();
+
+    message_t go_die = {
+            .message_type = MSG_GODIE,
+            .nbytes = 0,
+            .data = NULL
+    };
+    for (size_t i = 0; i < members; i++) {
+        send_or_report(member_ids[i], go_die);
+    }
+    send_or_report(actor_id_self(), go_die);
+}
+
+void on_hello_member(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(nbytes);
+
+    size_t *received = calloc(1, sizeof(size_t));
+    if (received == NULL) {
+        exit(EXIT_FAILURE);
+    }
+    *stateptr = received;
+
+    int err;
+    if ((err = actor_group_join(group, actor_id_self()))) {
+        fprintf(stderr, "Joining a group failed: %d\n", err);
+    }
+
+    message_t ready_message = {
+            .message_type = MSG_READY,
+            .nbytes = sizeof(actor_id_t),
+            .data = (void *) actor_id_self()
+    };
+    send_or_report((actor_id_t) data, ready_message);
+}
+
+void on_tick(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(nbytes);
+
+    bench_record_since(&latencies, data);
+
+    size_t *received = *stateptr;
+    if (++*received < ticks) {
+        return;
+    }
+
+    free(received);
+    *stateptr = NULL;
+
+    /* Only the last member reports, so that members never block the
+     * workers on the mailbox of the root. */
+    if (atomic_fetch_add(&done, 1) + 1 < members) {
+        return;
+    }
+
+    message_t done_message = {
+            .message_type = MSG_DONE,
+            .nbytes = 0,
+            .data = NULL
+    };
+    send_or_report(root, done_message);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        members = strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2) {
+        ticks = strtoul(argv[2], NULL, 10);
+    }
+    if (argc > 3) {
+        use_group = strcmp(argv[3], "loop") != 0;
+    }
+    if (ticks > ACTOR_QUEUE_LIMIT) {
+        ticks = ACTOR_QUEUE_LIMIT;
+    }
+
+    member_ids = malloc(members * sizeof(actor_id_t));
+    if (member_ids == NULL) {
+        exit(EXIT_FAILURE);
+    }
+
+    act_t acts_for_root[] = {on_hello_root, on_ready, NULL, on_done};
+    role_t role_for_root = {
+            .nprompts = MESSAGES_TYPES,
+            .prompts = acts_for_root
+    };
+    act_t acts_for_member[] = {on_hello_member, NULL, on_tick, NULL};
+    role_for_member = (role_t) {
+            .nprompts = MESSAGES_TYPES,
+            .prompts = acts_for_member
+    };
+
+    int err;
+    if ((err = create_or_report(&root, &role_for_root))) {
+        return err;
+    }
+    actor_system_join(root);
+
+    char parameters[64];
+    snprintf(parameters, sizeof(parameters), "mode=%s members=%zu ticks=%zu",
+             use_group ? "group" : "loop", members, ticks);
+    bench_report("broadcast", parameters, (double) members * (double) ticks,
+                 end - start, &latencies);
+
+    free(member_ids);
+
+    return 0;
+}
@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "bench.h"
+
+#ifndef MESSAGES_TYPES
+#define MESSAGES_TYPES 3
+#endif
+
+#ifndef MSG_REGISTER
+#define MSG_REGISTER 1
+#endif
+
+#ifndef MSG_ITEM
+#define MSG_ITEM 2
+#endif
+
+/* Producer threads keep sending to many actors at once, so that senders,
+ * the workers running the actors and the thieves taking them write to the
+ * same mailboxes, actors and run queues all the time. */
+size_t producers = 4;
+size_t actors = 64;
+size_t messages_per_producer = 200000;
+
+role_t role_for_actor;
+actor_id_t *actor_ids;
+size_t spawned;
+size_t registered;
+_Atomic size_t received;
+
+sem_t ready;
+sem_t done;
+bench_latencies_t latencies;
+
+/* Keeps the spawn requests the root sends to itself below the mailbox
+ * limit. */
+void spawn_actors(size_t n) {
+    message_t spawn = {
+            .message_type = MSG_SPAWN,
+            .nbytes = sizeof(role_t),
+            .data = &role_for_actor
+    };
+
+    for (size_t i = 0; i < n && spawned < actors; i++, spawned++) {
+        send_or_report(actor_id_self(), spawn);
+    }
+}
+
+void on_hello_root(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+    UNUSED(data);
+
+    spawn_actors(ACTOR_QUEUE_LIMIT / 4);
+}
+
+void on_register(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+
+    actor_ids[registered++] = (actor_id_t) data;
+    if (registered == actors) {
+        sem_post(&ready);
+    }
+    else {
+        spawn_actors(1);
+    }
+}
+
+void on_hello_actor(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+
+    message_t register_message = {
+            .message_type = MSG_REGISTER,
+            .nbytes = sizeof(actor_id_t),
+            .data = (void *) actor_id_self()
+    };
+    send_or_report((actor_id_t) data, register_message);
+}
+
+void on_item(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+
+    bench_record_since(&latencies, data);
+    if (atomic_fetch_add(&received, 1) + 1 == producers * messages_per_producer) {
+        sem_post(&done);
+    }
+}
+
+void *producer_function(void *arg) {
+    size_t next = (size_t) arg;
+    for (size_t i = 0; i < messages_per_producer; i++) {
+        send_or_report(actor_ids[next], bench_stamped_message(MSG_ITEM));
+        next = next + 1 < actors ? next + 1 : 0;
+    }
+
+    return NULL;
+}
+
+void wait_for(sem_t *sem) {
+    while (sem_wait(sem) != 0 && errno == EINTR) {
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        producers = strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2) {
+        actors = strtoul(argv[2], NULL, 10);
+    }
+    if (argc > 3) {
+        messages_per_producer = strtoul(argv[3], NULL, 10);
+    }
+
+    actor_ids = malloc(actors * sizeof(actor_id_t));
+    pthread_t *threads = malloc(producers * sizeof(pthread_t));
+    if (actor_ids == NULL || threads == NULL
+        || sem_init(&ready, 0, 0) != 0 || sem_init(&done, 0, 0) != 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    act_t acts_for_root[] = {on_hello_root, on_register, NULL};
+    role_t role_for_root = {
+            .nprompts = MESSAGES_TYPES,
+            .prompts = acts_for_root
+    };
+    act_t acts_for_actor[] = {on_hello_actor, NULL, on_item};
+    role_for_actor = (role_t) {
+            .nprompts = MESSAGES_TYPES,
+            .prompts = acts_for_actor
+    };
+
+    /* Opened first, so that the workers inherit the counters. */
+    bench_counters_t counters;
+    bench_counters_open(&counters);
+
+    actor_id_t root;
+    int err;
+    if ((err = create_or_report(&root, &role_for_root))) {
+        return err;
+    }
+    wait_for(&ready);
+
+    uint64_t start = bench_now_nsec();
+
+    for (size_t i = 0; i < producers; i++) {
+        pthread_create(&threads[i], NULL, producer_function,
+                       (void *) (i * actors / producers));
+    }
+    for (size_t i = 0; i < producers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    wait_for(&done);
+
+    uint64_t elapsed = bench_now_nsec() - start;
+
+    message_t go_die = {
+            .message_type = MSG_GODIE,
+            .nbytes = 0,
+            .data = NULL
+    };
+    for (size_t i = 0; i < actors; i++) {
+        send_or_report(actor_ids[i], go_die);
+    }
+    send_or_report(root, go_die);
+    actor_system_join(root);
+
+    double messages = (double) producers * (double) messages_per_producer;
+    char parameters[256];
+    int length = snprintf(parameters, sizeof(parameters),
+                          "producers=%zu actors=%zu ", producers, actors);
+    bench_counters_close(&counters, messages, parameters + length,
+                         sizeof(parameters) - (size_t) length);
+    bench_report("cache_lines", parameters, messages, elapsed, &latencies);
+
+    sem_destroy(&ready);
+    sem_destroy(&done);
+    free(threads);
+    free(actor_ids);
+
+    return 0;
+}
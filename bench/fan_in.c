@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "bench.h"
+
+#ifndef MESSAGES_TYPES
+#define MESSAGES_TYPES 2
+#endif
+
+#ifndef MSG_ITEM
+#define MSG_ITEM 1
+#endif
+
+size_t producers = 4;
+size_t messages_per_producer = 200000;
+size_t batch = 1;
+
+actor_id_t sink;
+size_t received;
+bench_latencies_t latencies;
+
+void on_hello_sink(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+    UNUSED(data);
+}
+
+void on_item(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+
+    bench_record_since(&latencies, data);
+    if (++received < producers * messages_per_producer) {
+        return;
+    }
+
+    message_t go_die = {
+            .message_type = MSG_GODIE,
+            .nbytes = 0,
+            .data = NULL
+    };
+    send_or_report(actor_id_self(), go_die);
+}
+
+void *producer_function(void *arg) {
+    UNUSED(arg);
+
+    int err;
+    if (batch <= 1) {
+        for (size_t i = 0; i < messages_per_producer; i++) {
+            send_or_report(sink, bench_stamped_message(MSG_ITEM));
+        }
+
+        return NULL;
+    }
+
+    message_t *items = malloc(batch * sizeof(message_t));
+    if (items == NULL) {
+        exit(EXIT_FAILURE);
+    }
+
+    size_t sent = 0;
+    while (sent < messages_per_producer) {
+        size_t n = messages_per_producer - sent < batch
+                   ? messages_per_producer - sent : batch;
+        for (size_t i = 0; i < n; i++) {
+            items[i] = bench_stamped_message(MSG_ITEM);
+        }
+        if ((err = send_messages(sink, items, n)) < 0) {
+            fprintf(stderr, "Sending messages to an actor failed: %d\n", err);
+            break;
+        }
+        sent += (size_t) err;
+    }
+
+    free(items);
+
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        producers = strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2) {
+        messages_per_producer = strtoul(argv[2], NULL, 10);
+    }
+    if (argc > 3) {
+        batch = strtoul(argv[3], NULL, 10);
+    }
+
+    act_t acts_for_sink[] = {on_hello_sink, on_item};
+    role_t role_for_sink = {
+            .nprompts = MESSAGES_TYPES,
+            .prompts = acts_for_sink
+    };
+
+    int err;
+    if ((err = create_or_report(&sink, &role_for_sink))) {
+        return err;
+    }
+
+    pthread_t *threads = malloc(producers * sizeof(pthread_t));
+    if (threads == NULL) {
+        exit(EXIT_FAILURE);
+    }
+
+    uint64_t start = bench_now_nsec();
+
+    for (size_t i = 0; i < producers; i++) {
+        pthread_create(&threads[i], NULL, producer_function, NULL);
+    }
+    for (size_t i = 0; i < producers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    actor_system_join(sink);
+    uint64_t elapsed = bench_now_nsec() - start;
+
+    char parameters[64];
+    snprintf(parameters, sizeof(parameters), "producers=%zu batch=%zu",
+             producers, batch);
+    bench_report("fan_in", parameters,
+                 (double) producers * (double) messages_per_producer,
+                 elapsed, &latencies);
+
+    free(threads);
+
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+#ifndef MESSAGES_TYPES
+#define MESSAGES_TYPES 4
+#endif
+
+#ifndef MSG_READY
+#define MSG_READY 1
+#endif
+
+#ifndef MSG_ITEM
+#define MSG_ITEM 2
+#endif
+
+#ifndef MSG_ACK
+#define MSG_ACK 3
+#endif
+
+size_t children = 256;
+size_t rounds = 2000;
+
+role_t role_for_child;
+actor_id_t *child_ids;
+
+size_t ready;
+size_t acks;
+size_t round_number;
+uint64_t start;
+uint64_t elapsed;
+bench_latencies_t latencies;
+
+/* A round goes out only once every child acknowledged the previous one,
+ * so that no mailbox ever fills up. */
+void send_round() {
+    for (size_t i = 0; i < children; i++) {
+        send_or_report(child_ids[i], bench_stamped_message(MSG_ITEM));
+    }
+}
+
+void on_hello_root(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+    UNUSED(data);
+
+    message_t spawn = {
+            .message_type = MSG_SPAWN,
+            .nbytes = sizeof(role_t),
+            .data = &role_for_child
+    };
+    for (size_t i = 0; i < children; i++) {
+        send_or_report(actor_id_self(), spawn);
+    }
+}
+
+void on_ready(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+
+    child_ids[ready++] = (actor_id_t) data;
+    if (ready == children) {
+        start = bench_now_nsec();
+        send_round();
+    }
+}
+
+void on_ack(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+    UNUSED(data);
+
+    if (++acks < children) {
+        return;
+    }
+
+    acks = 0;
+    if (++round_number < rounds) {
+        send_round();
+        return;
+    }
+
+    elapsed = bench_now_nsec() - start;
+
+    message_t go_die = {
+            .message_type = MSG_GODIE,
+            .nbytes = 0,
+            .data = NULL
+    };
+    for (size_t i = 0; i < children; i++) {
+        send_or_report(child_ids[i], go_die);
+    }
+    send_or_report(actor_id_self(), go_die);
+}
+
+void on_hello_child(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(nbytes);
+
+    *stateptr = data;
+
+    message_t ready_message = {
+            .message_type = MSG_READY,
+            .nbytes = sizeof(actor_id_t),
+            .data = (void *) actor_id_self()
+    };
+    send_or_report((actor_id_t) data, ready_message);
+}
+
+void on_item(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(nbytes);
+
+    bench_record_since(&latencies, data);
+
+    message_t ack = {
+            .message_type = MSG_ACK,
+            .nbytes = 0,
+            .data = NULL
+    };
+    send_or_report((actor_id_t) *stateptr, ack);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        children = strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2) {
+        rounds = strtoul(argv[2], NULL, 10);
+    }
+    if (children == 0 || rounds == 0) {
+        return 0;
+    }
+    if (children > ACTOR_QUEUE_LIMIT) {
+        children = ACTOR_QUEUE_LIMIT;
+    }
+
+    child_ids = malloc(children * sizeof(actor_id_t));
+    if (child_ids == NULL) {
+        exit(EXIT_FAILURE);
+    }
+
+    act_t acts_for_root[] = {on_hello_root, on_ready, NULL, on_ack};
+    role_t role_for_root = {
+            .nprompts = MESSAGES_TYPES,
+            .prompts = acts_for_root
+    };
+    act_t acts_for_child[] = {on_hello_child, NULL, on_item, NULL};
+    role_for_child = (role_t) {
+            .nprompts = MESSAGES_TYPES,
+            .prompts = acts_for_child
+    };
+
+    actor_id_t root;
+    int err;
+    if ((err = create_or_report(&root, &role_for_root))) {
+        return err;
+    }
+    actor_system_join(root);
+
+    char parameters[64];
+    snprintf(parameters, sizeof(parameters), "children=%zu rounds=%zu",
+             children, rounds);
+    bench_report("fan_out", parameters, (double) children * (double) rounds,
+                 elapsed, &latencies);
+
+    free(child_ids);
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+#ifndef MESSAGES_TYPES
+#define MESSAGES_TYPES 2
+#endif
+
+#ifndef MSG_TICK
+#define MSG_TICK 1
+#endif
+
+size_t total_messages = 2000000;
+size_t burst = ACTOR_QUEUE_LIMIT / 2;
+
+size_t sent;
+size_t received;
+bench_latencies_t latencies;
+
+void send_burst() {
+    message_t tick = {
+            .message_type = MSG_TICK,
+            .nbytes = 0,
+            .data = NULL
+    };
+
+    for (size_t i = 0; i < burst && sent < total_messages; i++, sent++) {
+        send_or_report(actor_id_self(), tick);
+    }
+}
+
+void on_hello(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+    UNUSED(data);
+
+    send_burst();
+}
+
+void on_tick(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+    UNUSED(data);
+
+    received++;
+    if (received == total_messages) {
+        message_t go_die = {
+                .message_type = MSG_GODIE,
+                .nbytes = 0,
+                .data = NULL
+        };
+        send_or_report(actor_id_self(), go_die);
+    }
+    else if (received == sent) {
+        send_burst();
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        total_messages = strtoul(argv[1], NULL, 10);
+    }
+
+    act_t acts[] = {on_hello, on_tick};
+    role_t role = {
+            .nprompts = MESSAGES_TYPES,
+            .prompts = acts
+    };
+
+    uint64_t start = bench_now_nsec();
+
+    actor_id_t actor;
+    int err;
+    if ((err = create_or_report(&actor, &role))) {
+        return err;
+    }
+
+    actor_system_join(actor);
+    uint64_t elapsed = bench_now_nsec() - start;
+
+    char parameters[64];
+    snprintf(parameters, sizeof(parameters), "activation_messages=%d",
+             ACTOR_ACTIVATION_MESSAGES);
+    bench_report("hot_actor", parameters, (double) total_messages, elapsed,
+                 &latencies);
+
+    return 0;
+}
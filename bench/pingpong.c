@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <semaphore.h>
+
+#include "bench.h"
+
+#ifndef MESSAGES_TYPES
+#define MESSAGES_TYPES 2
+#endif
+
+#ifndef MSG_PING
+#define MSG_PING 1
+#endif
+
+size_t rounds = 20000;
+unsigned long gap_usec = 0;
+
+sem_t pong;
+bench_latencies_t latencies;
+
+void on_hello(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+    UNUSED(data);
+}
+
+void on_ping(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+    UNUSED(data);
+
+    sem_post(&pong);
+}
+
+/* Every round trip starts from an idle system: the actor has drained its
+ * mailbox and, after gap_usec, the workers have gone idle as well. */
+void play(actor_id_t actor) {
+    message_t ping = {
+            .message_type = MSG_PING,
+            .nbytes = 0,
+            .data = NULL
+    };
+    struct timespec gap = {
+            .tv_sec = gap_usec / 1000000,
+            .tv_nsec = (long) (gap_usec % 1000000) * 1000
+    };
+
+    for (size_t i = 0; i < rounds; i++) {
+        uint64_t start = bench_now_nsec();
+        send_or_report(actor, ping);
+        while (sem_wait(&pong) != 0 && errno == EINTR) {
+        }
+        bench_latencies_record(&latencies, bench_now_nsec() - start);
+
+        if (gap_usec > 0) {
+            nanosleep(&gap, NULL);
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        rounds = strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2) {
+        gap_usec = strtoul(argv[2], NULL, 10);
+    }
+
+    if (sem_init(&pong, 0, 0) != 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    act_t acts[] = {on_hello, on_ping};
+    role_t role = {
+            .nprompts = MESSAGES_TYPES,
+            .prompts = acts
+    };
+
+    actor_id_t actor;
+    int err;
+    if ((err = create_or_report(&actor, &role))) {
+        return err;
+    }
+
+    uint64_t start = bench_now_nsec();
+    play(actor);
+    uint64_t elapsed = bench_now_nsec() - start;
+
+    message_t go_die = {
+            .message_type = MSG_GODIE,
+            .nbytes = 0,
+            .data = NULL
+    };
+    send_or_report(actor, go_die);
+    actor_system_join(actor);
+
+    char parameters[64];
+    snprintf(parameters, sizeof(parameters), "rounds=%zu gap_usec=%lu",
+             rounds, gap_usec);
+    bench_report("pingpong", parameters, (double) rounds, elapsed, &latencies);
+
+    sem_destroy(&pong);
+
+    return 0;
+}
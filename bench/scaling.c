@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+
+#include "bench.h"
+
+#ifndef MESSAGES_TYPES
+#define MESSAGES_TYPES 4
+#endif
+
+#ifndef MSG_REGISTER
+#define MSG_REGISTER 1
+#endif
+
+#ifndef MSG_TOKEN
+#define MSG_TOKEN 2
+#endif
+
+#ifndef MSG_DONE
+#define MSG_DONE 3
+#endif
+
+size_t actors_count = 256;
+long hops = 20000;
+long work = 2000;
+
+actor_id_t root;
+actor_id_t *ring;
+size_t registered;
+size_t done;
+bench_latencies_t latencies;
+
+void spin(long iterations) {
+    volatile unsigned long acc = 0;
+    for (long i = 0; i < iterations; i++) {
+        acc = acc * 31 + i;
+    }
+}
+
+void on_hello_root(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+    UNUSED(data);
+}
+
+void on_hello(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+
+    message_t registration = {
+            .message_type = MSG_REGISTER,
+            .nbytes = sizeof(actor_id_t),
+            .data = (void *) actor_id_self()
+    };
+    send_or_report((actor_id_t) data, registration);
+}
+
+void on_register(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+
+    ring[registered++] = (actor_id_t) data;
+    if (registered < actors_count) {
+        return;
+    }
+
+    for (size_t i = 0; i < actors_count; i++) {
+        message_t token = {
+                .message_type = MSG_TOKEN,
+                .nbytes = sizeof(long),
+                .data = (void *) hops
+        };
+        send_or_report(ring[i], token);
+    }
+}
+
+void on_token(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+
+    long remaining = (long) data;
+    spin(work);
+
+    message_t next = {
+            .message_type = MSG_DONE,
+            .nbytes = 0,
+            .data = NULL
+    };
+    actor_id_t target = root;
+    if (remaining > 0) {
+        next.message_type = MSG_TOKEN;
+        next.nbytes = sizeof(long);
+        next.data = (void *) (remaining - 1);
+        target = ring[(size_t) (actor_id_self() + remaining) % actors_count];
+    }
+    send_or_report(target, next);
+}
+
+void on_done(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+    UNUSED(data);
+
+    if (++done < actors_count) {
+        return;
+    }
+
+    message_t go_die = {
+            .message_type = MSG_GODIE,
+            .nbytes = 0,
+            .data = NULL
+    };
+    for (size_t i = 0; i < actors_count; i++) {
+        send_or_report(ring[i], go_die);
+    }
+    send_or_report(root, go_die);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        actors_count = strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2) {
+        hops = strtol(argv[2], NULL, 10);
+    }
+    if (argc > 3) {
+        work = strtol(argv[3], NULL, 10);
+    }
+
+    actor_system_config_t config;
+    actor_system_config_default(&config);
+    if (argc > 4) {
+        config.workers = strtoul(argv[4], NULL, 10);
+    }
+    if (argc > 5) {
+        config.pin_workers = strcmp(argv[5], "pin") == 0;
+    }
+
+    ring = malloc(actors_count * sizeof(actor_id_t));
+    if (ring == NULL) {
+        exit(EXIT_FAILURE);
+    }
+
+    act_t acts_for_root[] = {on_hello_root, on_register, on_token, on_done};
+    role_t role_for_root = {
+            .nprompts = MESSAGES_TYPES,
+            .prompts = acts_for_root
+    };
+    act_t acts_for_ring[] = {on_hello, on_register, on_token, on_done};
+    role_t role_for_ring = {
+            .nprompts = MESSAGES_TYPES,
+            .prompts = acts_for_ring
+    };
+
+    uint64_t start = bench_now_nsec();
+
+    int err;
+    if ((err = actor_system_create_config(&root, &role_for_root, &config))) {
+        fprintf(stderr, "Actor system creation failed: %d, %s\n",
+                errno, strerror(errno));
+
+        return err;
+    }
+
+    message_t spawn = {
+            .message_type = MSG_SPAWN,
+            .nbytes = sizeof(role_t),
+            .data = &role_for_ring
+    };
+    for (size_t i = 0; i < actors_count; i++) {
+        send_or_report(root, spawn);
+    }
+
+    actor_system_join(root);
+
+    uint64_t elapsed = bench_now_nsec() - start;
+
+    char parameters[64];
+    snprintf(parameters, sizeof(parameters), "workers=%zu pinned=%d actors=%zu",
+             config.workers, config.pin_workers, actors_count);
+    bench_report("scaling", parameters,
+                 (double) actors_count * (double) (hops + 1), elapsed, &latencies);
+
+    free(ring);
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+
+#include "bench.h"
+
+#ifndef MESSAGES_TYPES
+#define MESSAGES_TYPES 2
+#endif
+
+#ifndef MSG_FINISH
+#define MSG_FINISH 1
+#endif
+
+size_t actors_count = CAST_LIMIT;
+size_t spawned = 1;
+
+role_t *role_for_children;
+bench_latencies_t latencies;
+
+void spawn_or_finish() {
+    message_t next = {
+            .message_type = MSG_FINISH,
+            .nbytes = 0,
+            .data = NULL
+    };
+    if (spawned < actors_count) {
+        next.message_type = MSG_SPAWN;
+        next.nbytes = sizeof(role_t);
+        next.data = role_for_children;
+    }
+    send_or_report(actor_id_self(), next);
+}
+
+void on_hello_first_actor(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(nbytes);
+    UNUSED(data);
+
+    *stateptr = (void *) -1L;
+    spawn_or_finish();
+}
+
+void on_hello(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(nbytes);
+
+    *stateptr = data;
+    spawned++;
+    spawn_or_finish();
+}
+
+void on_finish(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(nbytes);
+    UNUSED(data);
+
+    actor_id_t parent = (actor_id_t) *stateptr;
+    if (parent >= 0) {
+        message_t finish = {
+                .message_type = MSG_FINISH,
+                .nbytes = 0,
+                .data = NULL
+        };
+        send_or_report(parent, finish);
+    }
+
+    message_t go_die = {
+            .message_type = MSG_GODIE,
+            .nbytes = 0,
+            .data = NULL
+    };
+    send_or_report(actor_id_self(), go_die);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        actors_count = strtoul(argv[1], NULL, 10);
+    }
+
+    act_t acts_for_first_actor[] = {on_hello_first_actor, on_finish};
+    role_t role_for_first_actor = {
+            .nprompts = MESSAGES_TYPES,
+            .prompts = acts_for_first_actor
+    };
+    act_t acts_for_next_actors[] = {on_hello, on_finish};
+    role_t role_for_next_actors = {
+            .nprompts = MESSAGES_TYPES,
+            .prompts = acts_for_next_actors
+    };
+    role_for_children = &role_for_next_actors;
+
+    uint64_t start = bench_now_nsec();
+
+    actor_id_t first_actor;
+    int err;
+    if ((err = create_or_report(&first_actor, &role_for_first_actor))) {
+        return err;
+    }
+
+    actor_system_join(first_actor);
+    uint64_t elapsed = bench_now_nsec() - start;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    char parameters[64];
+    snprintf(parameters, sizeof(parameters), "actors=%zu bytes_per_actor=%.0f",
+             spawned, (double) usage.ru_maxrss * 1024 / (double) spawned);
+    bench_report("spawn_memory", parameters, (double) spawned, elapsed,
+                 &latencies);
+
+    return 0;
+}
@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+
+#ifndef MESSAGES_TYPES
+#define MESSAGES_TYPES 2
+#endif
+
+#ifndef MSG_BATCH
+#define MSG_BATCH 1
+#endif
+
+size_t actors = 100000;
+const char *mode = "message";
+size_t batch = 256;
+
+role_t *role_for_actors;
+
+size_t spawned = 1;
+uint64_t spawn_sent_at;
+uint64_t *stamps;
+actor_id_t *batch_ids;
+bench_latencies_t latencies;
+
+void go_die() {
+    message_t go_die = {
+            .message_type = MSG_GODIE,
+            .nbytes = 0,
+            .data = NULL
+    };
+    send_or_report(actor_id_self(), go_die);
+}
+
+/* Like the chain of silnia, every actor spawns the next one, but it dies
+ * right after, so that dead actors keep getting reused. The latency runs
+ * from requesting a spawn to the hello of the new actor. */
+void on_hello_message(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+    UNUSED(data);
+
+    if (spawned > 1) {
+        bench_latencies_record(&latencies, bench_now_nsec() - spawn_sent_at);
+    }
+
+    if (spawned < actors) {
+        spawned++;
+        spawn_sent_at = bench_now_nsec();
+
+        message_t spawn = {
+                .message_type = MSG_SPAWN,
+                .nbytes = sizeof(role_t),
+                .data = role_for_actors
+        };
+        send_or_report(actor_id_self(), spawn);
+    }
+
+    go_die();
+}
+
+/* The same chain, but every actor is spawned directly, with the time of
+ * the request in its hello. */
+void on_hello_direct(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+
+    if (nbytes > 0) {
+        bench_record_since(&latencies, data);
+    }
+
+    if (spawned < actors) {
+        spawned++;
+
+        uint64_t now = bench_now_nsec();
+        if (actor_spawn(role_for_actors, sizeof(now), &now) < 0) {
+            fprintf(stderr, "Spawning an actor failed\n");
+        }
+    }
+
+    go_die();
+}
+
+/* The root spawns the actors a batch at a time, and each of them dies
+ * right after its hello. */
+void on_batch(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+    UNUSED(data);
+
+    size_t n = actors - spawned < batch ? actors - spawned : batch;
+    uint64_t now = bench_now_nsec();
+    for (size_t i = 0; i < n; i++) {
+        stamps[i] = now;
+    }
+    spawned += actor_spawn_many(role_for_actors, n, batch_ids,
+                                sizeof(uint64_t), stamps);
+
+    if (n > 0 && spawned < actors) {
+        message_t next_batch = {
+                .message_type = MSG_BATCH,
+                .nbytes = 0,
+                .data = NULL
+        };
+        send_or_report(actor_id_self(), next_batch);
+    }
+    else {
+        go_die();
+    }
+}
+
+void on_hello_root(void **stateptr, size_t nbytes, void *data) {
+    on_batch(stateptr, nbytes, data);
+}
+
+void on_hello_child(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(stateptr);
+    UNUSED(nbytes);
+
+    bench_record_since(&latencies, data);
+    go_die();
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        actors = strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2) {
+        mode = argv[2];
+    }
+    if (argc > 3) {
+        batch = strtoul(argv[3], NULL, 10);
+    }
+
+    act_t acts_for_message[] = {on_hello_message, NULL};
+    act_t acts_for_direct[] = {on_hello_direct, NULL};
+    act_t acts_for_root[] = {on_hello_root, on_batch};
+    act_t acts_for_children[] = {on_hello_child, NULL};
+
+    act_t *acts_for_first_actor = acts_for_message;
+    act_t *acts_for_actors = acts_for_message;
+    if (strcmp(mode, "direct") == 0) {
+        acts_for_first_actor = acts_for_actors = acts_for_direct;
+    }
+    else if (strcmp(mode, "many") == 0) {
+        acts_for_first_actor = acts_for_root;
+        acts_for_actors = acts_for_children;
+    }
+    else if (strcmp(mode, "message") != 0) {
+        fprintf(stderr, "Unknown mode %s, expected message, direct or many\n", mode);
+        return EXIT_FAILURE;
+    }
+
+    stamps = malloc(batch * sizeof(uint64_t));
+    batch_ids = malloc(batch * sizeof(actor_id_t));
+    if (stamps == NULL || batch_ids == NULL) {
+        exit(EXIT_FAILURE);
+    }
+
+    role_t role_for_first_actor = {
+            .nprompts = MESSAGES_TYPES,
+            .prompts = acts_for_first_actor
+    };
+    role_t role = {
+            .nprompts = MESSAGES_TYPES,
+            .prompts = acts_for_actors
+    };
+    role_for_actors = &role;
+
+    uint64_t start = bench_now_nsec();
+
+    actor_id_t first_actor;
+    int err;
+    if ((err = create_or_report(&first_actor, &role_for_first_actor))) {
+        return err;
+    }
+    actor_system_join(first_actor);
+
+    uint64_t elapsed = bench_now_nsec() - start;
+
+    char parameters[64];
+    snprintf(parameters, sizeof(parameters), "actors=%zu mode=%s", spawned, mode);
+    bench_report("spawn_storm", parameters, (double) spawned, elapsed, &latencies);
+
+    free(stamps);
+    free(batch_ids);
+
+    return 0;
+}
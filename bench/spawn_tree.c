@@ -0,0 +1,211 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+
+#ifndef MESSAGES_TYPES
+#define MESSAGES_TYPES 4
+#endif
+
+#ifndef MSG_READY
+#define MSG_READY 1
+#endif
+
+#ifndef MSG_WORK
+#define MSG_WORK 2
+#endif
+
+#ifndef MSG_RESULT
+#define MSG_RESULT 3
+#endif
+
+#define FANOUT 10
+
+size_t levels = 5;
+
+role_t role_for_nodes;
+
+_Atomic size_t nodes;
+uint64_t sum;
+bench_latencies_t latencies;
+
+typedef struct node {
+    actor_id_t parent;
+    size_t level;
+    uint64_t number;
+    uint64_t spawned_at;
+    size_t ready;
+    size_t pending;
+    uint64_t sum;
+} node_t;
+
+typedef struct work {
+    size_t level;
+    uint64_t number;
+} work_t;
+
+node_t *node_create(actor_id_t parent) {
+    node_t *node = calloc(1, sizeof(node_t));
+    if (node == NULL) {
+        exit(EXIT_FAILURE);
+    }
+    node->parent = parent;
+    atomic_fetch_add(&nodes, 1);
+
+    return node;
+}
+
+void send_number(actor_id_t actor, message_type_t message_type, uint64_t number) {
+    message_t message = {0};
+    message_inline(&message, message_type, &number, sizeof(number));
+    send_or_report(actor, message);
+}
+
+void node_finish(void **stateptr, uint64_t result) {
+    node_t *node = *stateptr;
+    if (node->parent >= 0) {
+        send_number(node->parent, MSG_RESULT, result);
+    }
+    else {
+        sum = result;
+    }
+
+    free(node);
+    *stateptr = NULL;
+
+    message_t go_die = {
+            .message_type = MSG_GODIE,
+            .nbytes = 0,
+            .data = NULL
+    };
+    send_or_report(actor_id_self(), go_die);
+}
+
+/* A leaf returns its number, an inner node spawns FANOUT children and
+ * returns the sum of theirs. */
+void node_start(void **stateptr) {
+    node_t *node = *stateptr;
+    if (node->level == levels) {
+        node_finish(stateptr, node->number);
+        return;
+    }
+
+    node->pending = FANOUT;
+    node->spawned_at = bench_now_nsec();
+
+    message_t spawn = {
+            .message_type = MSG_SPAWN,
+            .nbytes = sizeof(role_t),
+            .data = &role_for_nodes
+    };
+    for (size_t i = 0; i < FANOUT; i++) {
+        send_or_report(actor_id_self(), spawn);
+    }
+}
+
+void on_hello_root(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(nbytes);
+    UNUSED(data);
+
+    *stateptr = node_create(-1);
+    node_start(stateptr);
+}
+
+void on_hello_node(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(nbytes);
+
+    *stateptr = node_create((actor_id_t) data);
+
+    message_t ready = {
+            .message_type = MSG_READY,
+            .nbytes = sizeof(actor_id_t),
+            .data = (void *) actor_id_self()
+    };
+    send_or_report((actor_id_t) data, ready);
+}
+
+/* The latency runs from requesting the spawns to a child reporting. */
+void on_ready(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(nbytes);
+
+    node_t *node = *stateptr;
+    bench_latencies_record(&latencies, bench_now_nsec() - node->spawned_at);
+
+    work_t work = {
+            .level = node->level + 1,
+            .number = node->number * FANOUT + node->ready++
+    };
+    message_t message = {0};
+    message_inline(&message, MSG_WORK, &work, sizeof(work));
+    send_or_report((actor_id_t) data, message);
+}
+
+void on_work(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(nbytes);
+
+    node_t *node = *stateptr;
+    work_t work;
+    memcpy(&work, data, sizeof(work));
+    node->level = work.level;
+    node->number = work.number;
+
+    node_start(stateptr);
+}
+
+void on_result(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(nbytes);
+
+    node_t *node = *stateptr;
+    uint64_t result;
+    memcpy(&result, data, sizeof(result));
+    node->sum += result;
+
+    if (--node->pending == 0) {
+        node_finish(stateptr, node->sum);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        levels = strtoul(argv[1], NULL, 10);
+    }
+
+    act_t acts_for_root[] = {on_hello_root, on_ready, NULL, on_result};
+    role_t role_for_root = {
+            .nprompts = MESSAGES_TYPES,
+            .prompts = acts_for_root
+    };
+    act_t acts_for_nodes[] = {on_hello_node, on_ready, on_work, on_result};
+    role_for_nodes = (role_t) {
+            .nprompts = MESSAGES_TYPES,
+            .prompts = acts_for_nodes
+    };
+
+    uint64_t start = bench_now_nsec();
+
+    actor_id_t root;
+    int err;
+    if ((err = create_or_report(&root, &role_for_root))) {
+        return err;
+    }
+    actor_system_join(root);
+
+    uint64_t elapsed = bench_now_nsec() - start;
+
+    uint64_t leaves = 1;
+    for (size_t i = 0; i < levels; i++) {
+        leaves *= FANOUT;
+    }
+    if (sum != leaves * (leaves - 1) / 2) {
+        fprintf(stderr, "Sum of the leaves is %lu\n", (unsigned long) sum);
+    }
+
+    char parameters[64];
+    snprintf(parameters, sizeof(parameters), "levels=%zu actors=%zu",
+             levels, atomic_load(&nodes));
+    bench_report("spawn_tree", parameters, (double) atomic_load(&nodes),
+                 elapsed, &latencies);
+
+    return 0;
+}
@@ -1,3 +1,5 @@
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <pthread.h>
 #include <semaphore.h>
@@ -7,12 +9,71 @@
 #include <signal.h>
 #include <string.h>
 #include <errno.h>
+#include <sched.h>
+#include <time.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <limits.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <linux/futex.h>
 
 #include "cacti.h"
 
-#define FINISH_THREADS -1
 #define UNUSED(x) (void)(x)
 
+#define CACHE_LINE_SIZE 64
+
+#define RUN_QUEUE_CAPACITY 256
+#define INJECTION_QUEUE_INTERVAL 61
+#define WORKER_SPIN_ROUNDS 32
+#define WORKER_SPIN_PAUSES 32
+
+/* How long an actor may wait in run_next before idle workers take it. */
+#define RUN_NEXT_GRACE_NSEC 5000
+
+#define MAILBOX_COUNT_MASK (((uint64_t) 1 << 32) - 1)
+#define MAILBOX_CLOSED ((uint64_t) 1 << 32)
+#define MAILBOX_GENERATION_SHIFT 33
+#define MAILBOX_INITIAL_CAPACITY 4
+
+#define BROADCAST_BATCH (RUN_QUEUE_CAPACITY / 2)
+
+#define TIMER_TICK_NSEC 1000000L
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_SLOTS_LOG 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOTS_LOG)
+#define TIMER_INDEX_BITS 32
+
+#define BLOCKING_IDLE_NSEC 1000000000L
+
+#define STATS_HANDLERS_INITIAL_CAPACITY 16
+
+/* One in this many mailbox positions gets the time of its push, for
+ * queue_wait, as reading the clock on every send would slow it down. */
+#define STATS_QUEUE_WAIT_SAMPLE 16
+
+#define PAYLOAD_CLASSES 7
+#define PAYLOAD_MIN_SIZE_LOG 6
+#define PAYLOAD_SLAB_SIZE (64 * 1024)
+#define PAYLOAD_CACHE_SIZE 32
+
+#define ACTOR_INDEX_BITS 32
+#define ACTOR_GENERATION_MASK (((uint64_t) 1 << 31) - 1)
+
+#define NUMA_MAX_NODES 64
+#define NUMA_ARENA_CHUNK_SIZE ((size_t) 2 << 20)
+#define NUMA_ARENA_HEADER_SIZE 64
+#define NUMA_ARENA_MIN_SIZE_LOG 6
+#define NUMA_ARENA_CLASSES 40
+#define NUMA_MPOL_PREFERRED 1
+
+#define ACTOR_TABLE_FIRST_SEGMENT_LOG 10
+#define ACTOR_TABLE_SEGMENTS (sizeof(size_t) * 8 - ACTOR_TABLE_FIRST_SEGMENT_LOG)
+#define SEGMENT_SEALED ((size_t) 1 << (sizeof(size_t) * 8 - 1))
+
 void check_for_successful_alloc(void *data) {
     if (data == NULL) {
         fprintf(stderr, "Allocation failed: %d, %s\n", errno, strerror(errno));
@@ -20,6 +81,15 @@ void check_for_successful_alloc(void *data) {
     }
 }
 
+/* Memory starting at a cache line, for structures split into lines. */
+void *cache_aligned_alloc(size_t nbytes) {
+    void *data = aligned_alloc(CACHE_LINE_SIZE, (nbytes + CACHE_LINE_SIZE - 1)
+                                                / CACHE_LINE_SIZE * CACHE_LINE_SIZE);
+    check_for_successful_alloc(data);
+
+    return data;
+}
+
 void mutex_init(pthread_mutex_t *mutex, pthread_mutexattr_t *mutex_attr) {
     if (pthread_mutex_init(mutex, mutex_attr)) {
         fprintf(stderr, "Mutex initialisation failed: %d, %s\n",
@@ -88,6 +158,19 @@ void cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex) {
     }
 }
 
+/* Returns false once the deadline has passed. */
+bool cond_timedwait(pthread_cond_t *cond, pthread_mutex_t *mutex,
+                    const struct timespec *deadline) {
+    int err = pthread_cond_timedwait(cond, mutex, deadline);
+    if (err && err != ETIMEDOUT) {
+        fprintf(stderr, "Waiting on condition failed: %d, %s\n",
+                err, strerror(err));
+        exit(EXIT_FAILURE);
+    }
+
+    return err != ETIMEDOUT;
+}
+
 void cond_signal(pthread_cond_t *cond) {
     if (pthread_cond_signal(cond)) {
         fprintf(stderr, "Signaling on condition failed: %d, %s\n",
@@ -96,6 +179,14 @@ void cond_signal(pthread_cond_t *cond) {
     }
 }
 
+void cond_broadcast(pthread_cond_t *cond) {
+    if (pthread_cond_broadcast(cond)) {
+        fprintf(stderr, "Broadcasting on condition failed: %d, %s\n",
+                errno, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+}
+
 void cond_destroy(pthread_cond_t *cond) {
     if (pthread_cond_destroy(cond)) {
         fprintf(stderr, "Condition destruction failed: %d, %s\n",
@@ -112,6 +203,34 @@ void thread_create(pthread_t *thread, const pthread_attr_t *attr,
     }
 }
 
+void thread_attr_init(pthread_attr_t *attr) {
+    if (pthread_attr_init(attr)) {
+        fprintf(stderr, "Thread attributes initialization failed: %d, %s\n",
+                errno, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+}
+
+void thread_attr_destroy(pthread_attr_t *attr) {
+    if (pthread_attr_destroy(attr)) {
+        fprintf(stderr, "Thread attributes destruction failed: %d, %s\n",
+                errno, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* Names longer than the kernel allows are truncated. */
+void thread_set_name(pthread_t thread, const char *prefix, const char *suffix) {
+    if (prefix == NULL) {
+        return;
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "%s-%s", prefix, suffix);
+    name[15] = '\0';
+    pthread_setname_np(thread, name);
+}
+
 void thread_join(pthread_t thread, void **ret_val) {
     if (pthread_join(thread, ret_val)) {
         fprintf(stderr, "Thread joining failed: %d, %s\n", errno, strerror(errno));
@@ -119,76 +238,381 @@ void thread_join(pthread_t thread, void **ret_val) {
     }
 }
 
-typedef struct node node_t;
-
-struct node {
-    actor_id_t actor_id;
-    node_t *next;
-};
+typedef struct actor actor_t;
 
+/* Intrusive list of actors linked through next_scheduled. */
 typedef struct queue {
-    node_t *first;
-    node_t *last;
+    actor_t *first;
+    actor_t *last;
 } queue_t;
 
-typedef struct thread_pool {
+/* Bounded ring owned by a single worker. Only the owner pushes at the tail,
+ * while the owner and thieves claim actors from the head with a CAS. Both
+ * ends have cache lines of their own. */
+typedef struct run_queue {
+    _Alignas(CACHE_LINE_SIZE) _Atomic size_t head;
+    _Alignas(CACHE_LINE_SIZE) _Atomic size_t tail;
+    _Alignas(CACHE_LINE_SIZE) _Atomic(actor_t *) actors[RUN_QUEUE_CAPACITY];
+} run_queue_t;
+
+typedef struct histogram {
+    _Atomic uint64_t count;
+    _Atomic uint64_t sum;
+    _Atomic uint64_t max;
+    _Atomic uint64_t buckets[STATS_BUCKETS];
+} histogram_t;
+
+typedef struct handler_stats {
+    const role_t *role;
+    message_type_t message_type;
+    histogram_t handler_time;
+} handler_stats_t;
+
+typedef struct thread_stats thread_stats_t;
+
+/* Counters of a single thread, which updates them with plain relaxed loads
+ * and stores, so that they cost no more than ordinary increments, while
+ * actor_system_stats reads them at any time. Handler times are kept in an
+ * open addressing table keyed by role and message type, which only its
+ * thread grows, and others read, under mutex. */
+struct thread_stats {
+    _Atomic uint64_t activations;
+    _Atomic uint64_t busy_nsec;
+    _Atomic uint64_t steals;
+    _Atomic uint64_t stolen;
+    _Atomic uint64_t parks;
+    _Atomic uint64_t mailbox_high_water;
+    histogram_t queue_wait;
+    histogram_t schedule_wait;
+    handler_stats_t *last_handler;
+    handler_stats_t *handlers;
+    size_t handlers_capacity;
+    size_t nhandlers;
+    pthread_mutex_t mutex;
+    thread_stats_t *next;
+};
+
+typedef struct numa_chunk numa_chunk_t;
+
+/* Mapped memory of an arena, starting with this header. */
+struct numa_chunk {
+    numa_chunk_t *next;
+    size_t size;
+};
+
+/* Memory of a NUMA node, handed out in blocks of powers of two, which are
+ * kept on free lists once freed and unmapped only with the arena. Chunks
+ * are bound to node unless it is -1, which a simulated topology uses. */
+typedef struct numa_arena {
+    pthread_mutex_t mutex;
+    int node;
+    bool hugepages;
+    numa_chunk_t *chunks;
+    char *free_space;
+    size_t free_size;
+    void *free[NUMA_ARENA_CLASSES];
+} numa_arena_t;
+
+/* Actors spawned on a node are scheduled through its injection queue by
+ * threads of other nodes. The queue and the arena, written by different
+ * threads, do not share cache lines. */
+typedef struct numa_node {
+    cpu_set_t cpus;
+    _Alignas(CACHE_LINE_SIZE) pthread_mutex_t queue_mutex;
     queue_t *queue;
-    pthread_mutex_t queue_mutex;
-    pthread_cond_t queue_nonempty;
+    _Atomic size_t queue_length;
+    _Alignas(CACHE_LINE_SIZE) numa_arena_t arena;
+} numa_node_t;
+
+/* Workers, written mostly by their own threads, start at cache lines. An
+ * actor woken up by the one the worker is running waits in run_next, since
+ * run_next_at, to run right after it on the same CPU. Thieves leave it there
+ * for RUN_NEXT_GRACE_NSEC, so that a long handler does not hold it back. */
+typedef struct worker {
+    _Alignas(CACHE_LINE_SIZE) actor_system_t *system;
+    size_t index;
+    size_t node;
+    actor_t *running;
+    _Atomic(actor_t *) run_next;
+    _Atomic uint64_t run_next_at;
+    size_t ticks;
+    size_t spin_rounds;
+    unsigned int seed;
+    run_queue_t run_queue;
+    thread_stats_t stats;
+} worker_t;
+
+/* Without NUMA placement, there is a single node, and actors are allocated
+ * from the heap. Otherwise, worker i belongs to node i * nnodes / nworkers,
+ * and actors spawned outside of workers are spread over the nodes. Fields
+ * read on every scheduling decision are kept apart from the counters of
+ * parking and notifying workers, and from the spawn round-robin. */
+typedef struct thread_pool {
+    size_t nworkers;
+    size_t nnodes;
+    numa_node_t *nodes;
+    bool numa;
+    size_t max_spinning;
+    _Atomic bool finished;
     pthread_key_t key_actor_id;
+    pthread_key_t key_worker;
+    worker_t *workers;
     pthread_t *threads;
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint32_t epoch;
+    _Atomic size_t sleeping;
+    _Atomic size_t spinning;
+    _Alignas(CACHE_LINE_SIZE) _Atomic size_t next_node;
 } thread_pool_t;
 
-typedef struct buffer {
-    size_t first_pos;
-    size_t last_pos;
-    size_t size;
-    message_t messages[ACTOR_QUEUE_LIMIT];
-} buffer_t;
+/* What a mailbox keeps of a message besides the message itself.
+ * enqueued_at is 0 unless the position was sampled for queue_wait, and
+ * timer is the periodic timer that delivered the message, or -1. */
+typedef struct envelope {
+    uint64_t enqueued_at;
+    timer_id_t timer;
+} envelope_t;
+
+typedef struct mailbox_slot {
+    _Atomic size_t sequence;
+    envelope_t envelope;
+    message_t message;
+} mailbox_slot_t;
+
+typedef struct mailbox_segment mailbox_segment_t;
+
+/* Bounded multi-producer ring. Once it fills up, or the consumer shrinks an
+ * idle mailbox, it is sealed and producers move on to the next segment,
+ * whose capacity is next_capacity. The producer and the consumer ends, and
+ * the slots, start at cache lines of their own. */
+struct mailbox_segment {
+    _Alignas(CACHE_LINE_SIZE) _Atomic size_t enqueue_pos;
+    _Atomic size_t next_capacity;
+    _Atomic(mailbox_segment_t *) next;
+    _Alignas(CACHE_LINE_SIZE) _Atomic size_t dequeue_pos;
+    mailbox_segment_t *retired_next;
+    size_t capacity;
+    _Alignas(CACHE_LINE_SIZE) mailbox_slot_t slots[];
+};
+
+/* Multi-producer, single-consumer queue of segments, allocated on the first
+ * message. Producers reserve a place by incrementing the count in state,
+ * which also carries the closed flag and the generation of the actor that
+ * owns the mailbox, and touch the segments only while
+ * their message is counted there. Other threads reading the segments are
+ * counted in users. Segments left behind by the consumer are freed once
+ * neither count is positive. Senders wait while the count is at limit.
+ * Segments come from arena, or from malloc if it is NULL. What producers
+ * write is on one cache line, and what the consumer writes on the next. */
+typedef struct mailbox {
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t state;
+    _Atomic(mailbox_segment_t *) tail;
+    size_t limit;
+    numa_arena_t *arena;
+    _Alignas(CACHE_LINE_SIZE) _Atomic(mailbox_segment_t *) head;
+    mailbox_segment_t *retired;
+    size_t peak;
+    _Atomic size_t waiting;
+    _Atomic size_t users;
+} mailbox_t;
+
+typedef struct space_waiter space_waiter_t;
+
+/* An actor, possibly of another system, that found a lane full and is sent
+ * notify_type once it has room again. */
+struct space_waiter {
+    actor_system_t *system;
+    actor_id_t actor_id;
+    mailbox_t *mailbox;
+    message_type_t notify_type;
+    space_waiter_t *next;
+};
 
-typedef struct actor {
+/* Urgent messages go to a lane of their own, drained before the mailbox, so
+ * that they never wait behind its backlog. Both lanes carry the generation
+ * and are closed together. The first cache line holds what every send and
+ * activation touches, and the last what only full lanes, death and reuse
+ * do. */
+struct actor {
+    _Alignas(CACHE_LINE_SIZE) _Atomic bool scheduled;
+    actor_t *next_scheduled;
+    uint64_t scheduled_at;
     actor_id_t actor_id;
-    bool alive;
-    bool scheduled;
-    buffer_t *buffer;
+    actor_system_t *system;
+    size_t node;
     role_t *role;
     void *stateptr;
-    pthread_mutex_t mutex;
+    mailbox_t urgent;
+    mailbox_t mailbox;
+    _Alignas(CACHE_LINE_SIZE) pthread_mutex_t mutex;
+    pthread_cond_t urgent_space;
     pthread_cond_t buffer_space;
-} actor_t;
+    space_waiter_t *space_waiters;
+    actor_t *next_free;
+};
+
+/* Members are kept unordered, so that leaving is a swap with the last one.
+ * Members found dead by a broadcast are dropped. */
+typedef struct group {
+    char *name;
+    pthread_mutex_t mutex;
+    actor_id_t *members;
+    size_t nmembers;
+    size_t capacity;
+} group_t;
+
+typedef struct timer_entry timer_entry_t;
+
+/* A pending delivery of message to actor at tick expiry, repeated every
+ * period ticks if period is positive. Entries are linked into a slot of the
+ * wheel, or into the free list through next. */
+struct timer_entry {
+    timer_id_t timer_id;
+    uint64_t expiry;
+    uint64_t period;
+    actor_id_t actor;
+    message_t message;
+    bool armed;
+    bool in_flight;
+    timer_entry_t **slot;
+    timer_entry_t *prev;
+    timer_entry_t *next;
+};
+
+/* Hierarchical timing wheel with TIMER_WHEEL_LEVELS levels of
+ * TIMER_WHEEL_SLOTS slots, level l spanning TIMER_WHEEL_SLOTS^l ticks per
+ * slot. Entries move down a level every time the level below wraps around,
+ * and are delivered from level 0 by a runtime thread, so delays cost no
+ * worker time. Timer ids carry a generation, like actor ids. */
+typedef struct timer_wheel {
+    actor_system_t *system;
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+    pthread_t thread;
+    bool finished;
+    struct timespec start;
+    uint64_t now;
+    size_t armed;
+    timer_entry_t *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    timer_entry_t **timers;
+    size_t ntimers;
+    size_t timers_capacity;
+    timer_entry_t *free_timers;
+} timer_wheel_t;
+
+typedef struct blocking_job blocking_job_t;
+
+/* The rest of an activation, starting with message, handed over by a
+ * worker. The actor stays scheduled meanwhile. */
+struct blocking_job {
+    actor_t *actor;
+    message_t message;
+    envelope_t envelope;
+    blocking_job_t *next;
+};
+
+/* Elastic pool of up to BLOCKING_POOL_LIMIT detached threads for handlers
+ * that may block. A thread is started whenever more jobs wait than threads
+ * are idle, and exits after BLOCKING_IDLE_NSEC without work. */
+typedef struct blocking_executor {
+    actor_system_t *system;
+    pthread_mutex_t mutex;
+    pthread_cond_t job_available;
+    pthread_cond_t threads_exited;
+    blocking_job_t *first;
+    blocking_job_t *last;
+    size_t jobs;
+    size_t threads;
+    size_t idle;
+    bool finished;
+    thread_stats_t *thread_stats;
+    thread_stats_t retired_stats;
+} blocking_executor_t;
+
+typedef enum trace_event_type {
+    TRACE_SPAWN,
+    TRACE_SEND,
+    TRACE_SCHEDULE,
+    TRACE_DISPATCH_BEGIN,
+    TRACE_DISPATCH_END,
+    TRACE_DEATH
+} trace_event_type_t;
+
+typedef struct trace_event {
+    uint64_t timestamp;
+    actor_id_t actor_id;
+    message_type_t message_type;
+    trace_event_type_t type;
+} trace_event_t;
+
+typedef struct trace_buffer trace_buffer_t;
+
+/* Ring written only by its thread, which keeps the last CACTI_TRACE_EVENTS
+ * events; recorded counts all of them. */
+struct trace_buffer {
+    pthread_t thread;
+    size_t thread_index;
+    char thread_name[16];
+    _Atomic uint64_t recorded;
+    trace_buffer_t *next;
+    trace_event_t events[CACTI_TRACE_EVENTS];
+};
+
+/* Buffers of every thread that recorded an event since the actor system
+ * was created, which is the epoch they belong to. */
+typedef struct trace {
+    pthread_mutex_t mutex;
+    trace_buffer_t *buffers;
+    size_t nbuffers;
+    uint64_t epoch;
+    uint64_t start;
+} trace_t;
+
+/* Epochs are unique across all traces. */
+_Atomic uint64_t trace_epochs;
 
 typedef struct sigaction sigaction_t;
 
-typedef struct actor_system {
+/* Segment k holds 2^(ACTOR_TABLE_FIRST_SEGMENT_LOG + k) actors and is never
+ * moved once allocated. Entries below spawned_actors are published with a
+ * release store of spawned_actors, so lookups need no lock. Entries of dead
+ * actors are kept on the free_actors list and reused by later spawns. */
+struct actor_system {
     bool created;
     thread_pool_t *thread_pool;
-    actor_t **actors;
-    size_t actors_capacity;
-    size_t spawned_actors;
+    actor_t **actors[ACTOR_TABLE_SEGMENTS];
+    _Atomic size_t spawned_actors;
+    actor_t *free_actors;
+    size_t live_actors;
     bool spawning_allowed;
     pthread_mutex_t actors_mutex;
-    size_t dead_empty_actors;
+    group_t **groups;
+    size_t ngroups;
+    size_t groups_capacity;
+    pthread_mutex_t groups_mutex;
+    timer_wheel_t timer_wheel;
+    blocking_executor_t blocking_executor;
+    actor_system_config_t config;
+    trace_t trace;
     sigaction_t sigaction;
-} actor_system_t;
+    actor_system_t *next;
+};
 
-actor_system_t actor_system = {
+/* The system of actor_system_create, and of the threads that belong to no
+ * system. */
+actor_system_t default_system = {
         .created = false
 };
 
-node_t *node_create(actor_id_t actor_id, node_t *next) {
-    node_t *node = malloc(sizeof(node_t));
-    check_for_successful_alloc(node);
-    node->actor_id = actor_id;
-    node->next = next;
+/* Every created system, for SIGINT to reach all of them. */
+pthread_mutex_t systems_mutex = PTHREAD_MUTEX_INITIALIZER;
+actor_system_t *systems = NULL;
 
-    return node;
-}
+_Thread_local actor_system_t *thread_system;
 
-void node_destroy(node_t *node) {
-    free(node);
+actor_system_t *actor_system_self() {
+    return thread_system != NULL ? thread_system : &default_system;
 }
 
-
 queue_t *queue_create() {
     queue_t *queue = malloc(sizeof(queue_t));
     check_for_successful_alloc(queue);
@@ -202,477 +626,3839 @@ bool queue_empty(queue_t *queue) {
     return queue->first == NULL;
 }
 
-node_t *queue_pop(queue_t *queue) {
-    node_t *node = queue->first;
-    queue->first = node->next;
+actor_t *queue_pop(queue_t *queue) {
+    actor_t *actor = queue->first;
+    queue->first = actor->next_scheduled;
     if (queue_empty(queue)) {
         queue->last = NULL;
     }
 
-    return node;
+    return actor;
 }
 
-void queue_push(queue_t *queue, actor_id_t actor_id) {
-    node_t *node = node_create(actor_id, NULL);
+void queue_push(queue_t *queue, actor_t *actor) {
+    actor->next_scheduled = NULL;
     if (queue_empty(queue)) {
-        queue->first = node;
-        queue->last = node;
+        queue->first = actor;
+        queue->last = actor;
     }
     else {
-        queue->last->next = node;
-        queue->last = node;
+        queue->last->next_scheduled = actor;
+        queue->last = actor;
     }
 }
 
 void queue_destroy(queue_t *queue) {
-    while (!queue_empty(queue)) {
-        node_t *node = queue_pop(queue);
-        node_destroy(node);
-    }
     free(queue);
 }
 
 
-buffer_t *buffer_create() {
-    buffer_t *buffer = malloc(sizeof(buffer_t));
-    check_for_successful_alloc(buffer);
-    buffer->first_pos = 0;
-    buffer->last_pos = 0;
-    buffer->size = 0;
+/* Statistics of the thread running the code, NULL outside of workers and
+ * threads of the blocking executor. */
+_Thread_local thread_stats_t *thread_stats;
 
-    return buffer;
+uint64_t clock_nsec() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
 }
 
-bool buffer_empty(buffer_t *buffer) {
-    return buffer->size == 0;
+void counter_add(_Atomic uint64_t *counter, uint64_t n) {
+    atomic_store_explicit(counter,
+                          atomic_load_explicit(counter, memory_order_relaxed) + n,
+                          memory_order_relaxed);
 }
 
-bool buffer_full(buffer_t *buffer) {
-    return buffer->size == ACTOR_QUEUE_LIMIT;
+void counter_max(_Atomic uint64_t *counter, uint64_t value) {
+    if (value > atomic_load_explicit(counter, memory_order_relaxed)) {
+        atomic_store_explicit(counter, value, memory_order_relaxed);
+    }
 }
 
-void buffer_push(buffer_t *buffer, message_t message) {
-    buffer->messages[buffer->last_pos] = message;
-    buffer->last_pos = (buffer->last_pos + 1) % ACTOR_QUEUE_LIMIT;
-    buffer->size++;
+uint64_t counter_read(_Atomic uint64_t *counter) {
+    return atomic_load_explicit(counter, memory_order_relaxed);
 }
 
-message_t buffer_pop(buffer_t *buffer) {
-    message_t message = buffer->messages[buffer->first_pos];
-    buffer->first_pos = (buffer->first_pos + 1) % ACTOR_QUEUE_LIMIT;
-    buffer->size--;
+size_t histogram_bucket(uint64_t value) {
+    size_t bucket = value == 0 ? 0 : 64 - (size_t) __builtin_clzll(value);
 
-    return message;
+    return bucket < STATS_BUCKETS ? bucket : STATS_BUCKETS - 1;
 }
 
-void buffer_destroy(buffer_t *buffer) {
-    free(buffer);
+void histogram_record(histogram_t *histogram, uint64_t value) {
+    counter_add(&histogram->count, 1);
+    counter_add(&histogram->sum, value);
+    counter_max(&histogram->max, value);
+    counter_add(&histogram->buckets[histogram_bucket(value)], 1);
 }
 
+/* Only for histograms no other thread writes to. */
+void histogram_merge(histogram_t *destination, histogram_t *source) {
+    counter_add(&destination->count, counter_read(&source->count));
+    counter_add(&destination->sum, counter_read(&source->sum));
+    counter_max(&destination->max, counter_read(&source->max));
+    for (size_t i = 0; i < STATS_BUCKETS; i++) {
+        counter_add(&destination->buckets[i], counter_read(&source->buckets[i]));
+    }
+}
 
-actor_t *actor_create(actor_id_t actor_id, role_t *role) {
-    actor_t *actor = malloc(sizeof(actor_t));
-    check_for_successful_alloc(actor);
-    actor->actor_id = actor_id;
-    actor->alive = true;
-    actor->scheduled = false;
-    actor->buffer = buffer_create();
-    actor->role = role;
-    actor->stateptr = NULL;
+void histogram_export(stats_histogram_t *destination, histogram_t *source) {
+    destination->count += counter_read(&source->count);
+    destination->sum += counter_read(&source->sum);
+    uint64_t max = counter_read(&source->max);
+    if (max > destination->max) {
+        destination->max = max;
+    }
+    for (size_t i = 0; i < STATS_BUCKETS; i++) {
+        destination->buckets[i] += counter_read(&source->buckets[i]);
+    }
+}
 
-    mutex_recursive_init(&actor->mutex);
-    cond_init(&actor->buffer_space, NULL);
+void stats_histogram_add(stats_histogram_t *destination,
+                         const stats_histogram_t *source) {
+    destination->count += source->count;
+    destination->sum += source->sum;
+    if (source->max > destination->max) {
+        destination->max = source->max;
+    }
+    for (size_t i = 0; i < STATS_BUCKETS; i++) {
+        destination->buckets[i] += source->buckets[i];
+    }
+}
 
-    return actor;
+void thread_stats_init(thread_stats_t *stats) {
+    memset(stats, 0, sizeof(thread_stats_t));
+    mutex_init(&stats->mutex, NULL);
 }
 
-void actor_destroy(actor_t *actor) {
-    buffer_destroy(actor->buffer);
-    mutex_destroy(&actor->mutex);
-    cond_destroy(&actor->buffer_space);
-    free(actor);
+void thread_stats_destroy(thread_stats_t *stats) {
+    free(stats->handlers);
+    mutex_destroy(&stats->mutex);
 }
 
+size_t handler_stats_slot(const role_t *role, message_type_t message_type,
+                          size_t capacity) {
+    uint64_t hash = ((uint64_t) (uintptr_t) role >> 4) * 0x9e3779b97f4a7c15u
+                    + (uint64_t) message_type * 0xbf58476d1ce4e5b9u;
 
-actor_id_t actor_system_spawn_actor(role_t *role);
+    return (size_t) (hash >> 32) & (capacity - 1);
+}
 
-int actor_send_hello_message(actor_id_t actor_id, size_t nbytes, void *data) {
-    message_t hello_message = {
-            .message_type = MSG_HELLO,
-            .nbytes = nbytes,
-            .data = data
-    };
+handler_stats_t *thread_stats_probe(handler_stats_t *handlers, size_t capacity,
+                                    const role_t *role, message_type_t message_type) {
+    size_t slot = handler_stats_slot(role, message_type, capacity);
+    while (handlers[slot].role != NULL
+           && (handlers[slot].role != role
+               || handlers[slot].message_type != message_type)) {
+        slot = (slot + 1) & (capacity - 1);
+    }
 
-    return send_message(actor_id, hello_message);
+    return &handlers[slot];
 }
 
-void actor_handle_message(actor_t *actor, message_t *message) {
-    if (message->message_type == MSG_SPAWN) {
-        actor_id_t new_actor = actor_system_spawn_actor(message->data);
-        if (new_actor < 0) {
-            fprintf(stderr, "%s: failed to spawn a new actor\n", __func__);
-        }
-        else {
-            int err = actor_send_hello_message(
-                    new_actor, sizeof(actor_id_t), (void *) actor->actor_id);
-            if (err) {
-                fprintf(stderr,
-                        "%s: failed to send hello to a new actor\n", __func__);
-            }
+/* Keeps the table at most half full. Called by the owning thread only. */
+void thread_stats_grow(thread_stats_t *stats) {
+    size_t capacity = stats->handlers_capacity == 0
+                      ? STATS_HANDLERS_INITIAL_CAPACITY
+                      : 2 * stats->handlers_capacity;
+    handler_stats_t *handlers = calloc(capacity, sizeof(handler_stats_t));
+    check_for_successful_alloc(handlers);
+
+    for (size_t i = 0; i < stats->handlers_capacity; i++) {
+        handler_stats_t *old = &stats->handlers[i];
+        if (old->role != NULL) {
+            handler_stats_t *moved = thread_stats_probe(handlers, capacity,
+                                                        old->role, old->message_type);
+            moved->role = old->role;
+            moved->message_type = old->message_type;
+            histogram_merge(&moved->handler_time, &old->handler_time);
         }
     }
-    else if (message->message_type == MSG_GODIE) {
-        actor->alive = false;
+
+    free(stats->handlers);
+    stats->handlers = handlers;
+    stats->handlers_capacity = capacity;
+    stats->last_handler = NULL;
+}
+
+/* Consecutive messages mostly go to the same handler, which is looked up
+ * first. */
+handler_stats_t *thread_stats_handler(thread_stats_t *stats, const role_t *role,
+                                      message_type_t message_type) {
+    handler_stats_t *last_handler = stats->last_handler;
+    if (last_handler != NULL && last_handler->role == role
+        && last_handler->message_type == message_type) {
+        return last_handler;
     }
-    else if (message->message_type == MSG_HELLO) {
-        actor->role->prompts[0](&actor->stateptr, message->nbytes, message->data);
+    else if (stats->handlers_capacity > 0) {
+        handler_stats_t *handler = thread_stats_probe(
+                stats->handlers, stats->handlers_capacity, role, message_type);
+        if (handler->role != NULL) {
+            stats->last_handler = handler;
+
+            return handler;
+        }
     }
-    else if ((size_t) message->message_type < actor->role->nprompts) {
-        actor->role->prompts[message->message_type](&actor->stateptr,
-                                                    message->nbytes, message->data);
+
+    mutex_lock(&stats->mutex);
+
+    if (2 * (stats->nhandlers + 1) > stats->handlers_capacity) {
+        thread_stats_grow(stats);
     }
-    else {
-        fprintf(stderr, "%s: invalid message type\n", __func__);
+    handler_stats_t *handler = thread_stats_probe(
+            stats->handlers, stats->handlers_capacity, role, message_type);
+    handler->role = role;
+    handler->message_type = message_type;
+    stats->nhandlers++;
+
+    mutex_unlock(&stats->mutex);
+
+    return handler;
+}
+
+/* Adds the counters of a thread that exits to those of another one. The
+ * caller serializes writers of the destination. */
+void thread_stats_merge(thread_stats_t *destination, thread_stats_t *source) {
+    counter_add(&destination->activations, counter_read(&source->activations));
+    counter_add(&destination->busy_nsec, counter_read(&source->busy_nsec));
+    counter_add(&destination->steals, counter_read(&source->steals));
+    counter_add(&destination->stolen, counter_read(&source->stolen));
+    counter_add(&destination->parks, counter_read(&source->parks));
+    counter_max(&destination->mailbox_high_water,
+                counter_read(&source->mailbox_high_water));
+    histogram_merge(&destination->queue_wait, &source->queue_wait);
+    histogram_merge(&destination->schedule_wait, &source->schedule_wait);
+
+    for (size_t i = 0; i < source->handlers_capacity; i++) {
+        handler_stats_t *handler = &source->handlers[i];
+        if (handler->role != NULL) {
+            histogram_merge(&thread_stats_handler(destination, handler->role,
+                                                  handler->message_type)->handler_time,
+                            &handler->handler_time);
+        }
     }
 }
 
-void actor_schedule_for_execution(actor_id_t actor) {
-    mutex_lock(&actor_system.thread_pool->queue_mutex);
+void thread_stats_export(thread_stats_summary_t *summary, thread_stats_t *stats) {
+    mutex_lock(&stats->mutex);
+
+    summary->activations += counter_read(&stats->activations);
+    summary->busy_nsec += counter_read(&stats->busy_nsec);
+    summary->steals += counter_read(&stats->steals);
+    summary->stolen += counter_read(&stats->stolen);
+    summary->parks += counter_read(&stats->parks);
+    uint64_t high_water = counter_read(&stats->mailbox_high_water);
+    if (high_water > summary->mailbox_high_water) {
+        summary->mailbox_high_water = high_water;
+    }
+    histogram_export(&summary->queue_wait, &stats->queue_wait);
+    histogram_export(&summary->schedule_wait, &stats->schedule_wait);
 
-    queue_push(actor_system.thread_pool->queue, actor);
-    actor_system.actors[actor]->scheduled = true;
+    for (size_t i = 0; i < stats->handlers_capacity; i++) {
+        if (stats->handlers[i].role != NULL) {
+            histogram_export(&summary->handler_time,
+                             &stats->handlers[i].handler_time);
+        }
+    }
+    summary->messages = summary->handler_time.count;
 
-    cond_signal(&actor_system.thread_pool->queue_nonempty);
-    mutex_unlock(&actor_system.thread_pool->queue_mutex);
+    mutex_unlock(&stats->mutex);
 }
 
+void thread_stats_export_handler(stats_histogram_t *histogram, thread_stats_t *stats,
+                                 const role_t *role, message_type_t message_type) {
+    mutex_lock(&stats->mutex);
 
-void *thread_function(void *arg) {
-    UNUSED(arg);
+    if (stats->handlers_capacity > 0) {
+        handler_stats_t *handler = thread_stats_probe(
+                stats->handlers, stats->handlers_capacity, role, message_type);
+        if (handler->role != NULL) {
+            histogram_export(histogram, &handler->handler_time);
+        }
+    }
 
-    thread_pool_t *thread_pool = actor_system.thread_pool;
-    pthread_mutex_t *queue_mutex = &thread_pool->queue_mutex;
-    pthread_cond_t *queue_nonempty = &thread_pool->queue_nonempty;
+    mutex_unlock(&stats->mutex);
+}
 
-    while (true) {
-        mutex_lock(queue_mutex);
+void thread_summary_add(thread_stats_summary_t *destination,
+                        const thread_stats_summary_t *source) {
+    destination->activations += source->activations;
+    destination->messages += source->messages;
+    destination->busy_nsec += source->busy_nsec;
+    destination->steals += source->steals;
+    destination->stolen += source->stolen;
+    destination->parks += source->parks;
+    if (source->mailbox_high_water > destination->mailbox_high_water) {
+        destination->mailbox_high_water = source->mailbox_high_water;
+    }
+    stats_histogram_add(&destination->queue_wait, &source->queue_wait);
+    stats_histogram_add(&destination->schedule_wait, &source->schedule_wait);
+    stats_histogram_add(&destination->handler_time, &source->handler_time);
+}
 
-        while (queue_empty(thread_pool->queue)) {
-            cond_wait(queue_nonempty, queue_mutex);
-        }
+#if CACTI_TRACE
+#define TRACE(system, type, actor_id, message_type) \
+    trace_record(&(system)->trace, type, actor_id, message_type)
+#else
+#define TRACE(system, type, actor_id, message_type)
+#endif
+
+_Thread_local trace_buffer_t *trace_buffer;
+_Thread_local uint64_t trace_buffer_epoch;
+
+void trace_init(trace_t *trace) {
+    mutex_init(&trace->mutex, NULL);
+    trace->buffers = NULL;
+    trace->nbuffers = 0;
+    trace->epoch = atomic_fetch_add(&trace_epochs, 1) + 1;
+    trace->start = clock_nsec();
+}
 
-        node_t *node = queue_pop(thread_pool->queue);
-        actor_id_t actor_id = node->actor_id;
-        node_destroy(node);
+/* A thread registers its buffer with the first event it records into the
+ * trace. The buffer of the last trace recorded into is remembered, and the
+ * others are looked up. */
+trace_buffer_t *trace_thread_buffer(trace_t *trace) {
+    if (trace_buffer != NULL && trace_buffer_epoch == trace->epoch) {
+        return trace_buffer;
+    }
 
-        if (actor_id == FINISH_THREADS) {
-            break;
-        }
+    mutex_lock(&trace->mutex);
 
-        mutex_unlock(queue_mutex);
+    trace_buffer_t *buffer = trace->buffers;
+    while (buffer != NULL && !pthread_equal(buffer->thread, pthread_self())) {
+        buffer = buffer->next;
+    }
 
-        mutex_lock(&actor_system.actors_mutex);
-        actor_t *actor = actor_system.actors[actor_id];
-        mutex_unlock(&actor_system.actors_mutex);
+    if (buffer == NULL) {
+        buffer = malloc(sizeof(trace_buffer_t));
+        check_for_successful_alloc(buffer);
+        buffer->thread = pthread_self();
+        atomic_init(&buffer->recorded, 0);
+        if (pthread_getname_np(pthread_self(), buffer->thread_name,
+                               sizeof(buffer->thread_name))) {
+            strcpy(buffer->thread_name, "thread");
+        }
 
-        mutex_lock(&actor->mutex);
+        buffer->thread_index = trace->nbuffers++;
+        buffer->next = trace->buffers;
+        trace->buffers = buffer;
+    }
 
-        message_t message = buffer_pop(actor->buffer);
+    mutex_unlock(&trace->mutex);
 
-        cond_signal(&actor->buffer_space);
-        mutex_unlock(&actor->mutex);
+    trace_buffer = buffer;
+    trace_buffer_epoch = trace->epoch;
 
-        pthread_setspecific(thread_pool->key_actor_id, &actor->actor_id);
-        actor_handle_message(actor, &message);
+    return buffer;
+}
 
-        mutex_lock(&actor->mutex);
+void trace_record(trace_t *trace, trace_event_type_t type, actor_id_t actor_id,
+                  message_type_t message_type) {
+    trace_buffer_t *buffer = trace_thread_buffer(trace);
+    uint64_t recorded = atomic_load_explicit(&buffer->recorded, memory_order_relaxed);
 
-        if (!buffer_empty(actor->buffer)) {
-            actor_schedule_for_execution(actor_id);
-        }
-        else if (!actor->alive) {
-            mutex_unlock(&actor->mutex);
-            mutex_lock(&actor_system.actors_mutex);
+    trace_event_t *event = &buffer->events[recorded % CACTI_TRACE_EVENTS];
+    event->timestamp = clock_nsec();
+    event->actor_id = actor_id;
+    event->message_type = message_type;
+    event->type = type;
 
-            actor_system.dead_empty_actors++;
-            if (actor_system.dead_empty_actors == actor_system.spawned_actors) {
-                mutex_lock(queue_mutex);
+    atomic_store_explicit(&buffer->recorded, recorded + 1, memory_order_release);
+}
 
-                for (size_t i = 0; i < POOL_SIZE; i++) {
-                    queue_push(actor_system.thread_pool->queue, FINISH_THREADS);
-                    cond_signal(queue_nonempty);
-                }
+void trace_write_event(FILE *file, trace_t *trace, trace_buffer_t *buffer,
+                       trace_event_t *event) {
+    static const char *names[] = {
+            [TRACE_SPAWN] = "spawn",
+            [TRACE_SEND] = "send",
+            [TRACE_SCHEDULE] = "schedule",
+            [TRACE_DISPATCH_BEGIN] = "dispatch",
+            [TRACE_DISPATCH_END] = "dispatch",
+            [TRACE_DEATH] = "death"
+    };
+    const char *phase = event->type == TRACE_DISPATCH_BEGIN ? "B"
+                        : event->type == TRACE_DISPATCH_END ? "E" : "i";
+    uint64_t since_start = event->timestamp - trace->start;
+
+    fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"%s\",%s\"pid\":1,\"tid\":%zu,"
+                  "\"ts\":%" PRIu64 ".%03" PRIu64 ",\"args\":{\"actor\":%ld,"
+                  "\"message_type\":%ld}}",
+            names[event->type], phase, *phase == 'i' ? "\"s\":\"t\"," : "",
+            buffer->thread_index, since_start / 1000, since_start % 1000,
+            event->actor_id, event->message_type);
+}
 
-                mutex_unlock(queue_mutex);
+/* Called once every thread has stopped recording. Older events of threads
+ * that recorded more than CACTI_TRACE_EVENTS are lost. */
+void trace_dump(trace_t *trace, const char *path) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "%s: opening %s failed: %d, %s\n",
+                __func__, path, errno, strerror(errno));
+    }
+    else {
+        fprintf(file, "{\"traceEvents\":[\n{\"name\":\"process_name\",\"ph\":\"M\","
+                      "\"pid\":1,\"args\":{\"name\":\"cacti\"}}");
+
+        for (trace_buffer_t *buffer = trace->buffers; buffer != NULL;
+             buffer = buffer->next) {
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                          "\"tid\":%zu,\"args\":{\"name\":\"%s\"}}",
+                    buffer->thread_index, buffer->thread_name);
+
+            uint64_t recorded = atomic_load(&buffer->recorded);
+            uint64_t first = recorded > CACTI_TRACE_EVENTS
+                             ? recorded - CACTI_TRACE_EVENTS : 0;
+            for (uint64_t i = first; i < recorded; i++) {
+                trace_write_event(file, trace, buffer,
+                                  &buffer->events[i % CACTI_TRACE_EVENTS]);
             }
-
-            mutex_unlock(&actor_system.actors_mutex);
-            continue;
         }
 
-        if (buffer_empty(actor->buffer)) {
-            actor->scheduled = false;
-        }
+        fprintf(file, "\n]}\n");
+        fclose(file);
+    }
 
-        mutex_unlock(&actor->mutex);
+    while (trace->buffers != NULL) {
+        trace_buffer_t *buffer = trace->buffers;
+        trace->buffers = buffer->next;
+        free(buffer);
     }
+    trace->nbuffers = 0;
+    mutex_destroy(&trace->mutex);
+}
 
-    mutex_unlock(queue_mutex);
+void stats_mailbox_depth(size_t depth) {
+    if (CACTI_STATS && thread_stats != NULL) {
+        counter_max(&thread_stats->mailbox_high_water, depth);
+    }
+}
 
-    return NULL;
+void stats_handler_time(const role_t *role, message_type_t message_type,
+                        uint64_t nsec) {
+    if (CACTI_STATS && thread_stats != NULL) {
+        histogram_record(&thread_stats_handler(thread_stats, role,
+                                               message_type)->handler_time, nsec);
+    }
 }
 
-void sigint_handler(int sig) {
-    UNUSED(sig);
+bool stats_enqueue_sampled(size_t pos) {
+    return CACTI_STATS && (pos & (STATS_QUEUE_WAIT_SAMPLE - 1)) == 0;
+}
 
-    mutex_lock(&actor_system.actors_mutex);
-    actor_system.spawning_allowed = false;
-    mutex_unlock(&actor_system.actors_mutex);
+uint64_t stats_enqueue_stamp(size_t pos) {
+    return stats_enqueue_sampled(pos) ? clock_nsec() : 0;
+}
 
-    for (size_t i = 0; i < actor_system.spawned_actors; i++) {
-        actor_t *actor = actor_system.actors[i];
-        mutex_lock(&actor->mutex);
-        actor->alive = false;
-        mutex_unlock(&actor->mutex);
+/* A message pushed after the dispatching thread read the clock counts as
+ * not having waited. */
+void stats_queue_wait(uint64_t now, uint64_t enqueued_at) {
+    if (CACTI_STATS && thread_stats != NULL && enqueued_at != 0) {
+        histogram_record(&thread_stats->queue_wait,
+                         now > enqueued_at ? now - enqueued_at : 0);
     }
+}
 
-    actor_system_join(0);
+void numa_arena_init(numa_arena_t *arena, int node, bool hugepages) {
+    mutex_init(&arena->mutex, NULL);
+    arena->node = node;
+    arena->hugepages = hugepages;
+    arena->chunks = NULL;
+    arena->free_space = NULL;
+    arena->free_size = 0;
+    memset(arena->free, 0, sizeof(arena->free));
 }
 
-void *thread_signal_handler_function(void *arg) {
-    UNUSED(arg);
+/* Huge pages are taken from the reserved pool if possible, and asked of
+ * transparent huge pages otherwise. The binding is best effort. */
+numa_chunk_t *numa_arena_map(numa_arena_t *arena, size_t size) {
+    void *memory = MAP_FAILED;
+    if (arena->hugepages) {
+        memory = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+    if (memory == MAP_FAILED) {
+        memory = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        check_for_successful_alloc(memory == MAP_FAILED ? NULL : memory);
+        if (arena->hugepages) {
+            madvise(memory, size, MADV_HUGEPAGE);
+        }
+    }
 
-    int old_type;
-    if (pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, &old_type)) {
-        fprintf(stderr, "%s: pthread_setcanceltype failed, %d, %s\n",
-                __func__, errno, strerror(errno));
-        exit(EXIT_FAILURE);
+    if (arena->node >= 0) {
+        unsigned long nodes[NUMA_MAX_NODES / (8 * sizeof(unsigned long))] = {0};
+        nodes[arena->node / (8 * sizeof(unsigned long))] |=
+                1ul << (arena->node % (8 * sizeof(unsigned long)));
+        syscall(SYS_mbind, memory, size, NUMA_MPOL_PREFERRED, nodes,
+                NUMA_MAX_NODES + 1, 0);
     }
 
-    sigset_t block_mask;
-    sigemptyset(&block_mask);
-    sigaddset(&block_mask, SIGINT);
-    pthread_sigmask(SIG_UNBLOCK, &block_mask, NULL);
+    numa_chunk_t *chunk = memory;
+    chunk->next = arena->chunks;
+    chunk->size = size;
+    arena->chunks = chunk;
 
-    int sig;
-    if (sigwait(&block_mask, &sig)) {
-        fprintf(stderr, "%s: sigwait failed, %d, %s\n",
-                __func__, errno, strerror(errno));
+    return chunk;
+}
+
+size_t numa_arena_class(size_t nbytes) {
+    size_t size_class = 0;
+    while (((size_t) 1 << (NUMA_ARENA_MIN_SIZE_LOG + size_class)) < nbytes) {
+        size_class++;
     }
 
-    return NULL;
+    return size_class;
 }
 
-void thread_pool_create() {
-    thread_pool_t *thread_pool = malloc(sizeof(thread_pool_t));
-    check_for_successful_alloc(thread_pool);
-    actor_system.thread_pool = thread_pool;
-    thread_pool->queue = queue_create();
-
-    mutex_init(&thread_pool->queue_mutex, NULL);
-    cond_init(&thread_pool->queue_nonempty, NULL);
-    if (pthread_key_create(&thread_pool->key_actor_id, NULL)) {
-        fprintf(stderr, "%s: pthread_key_create failed, %d, %s\n",
-                __func__, errno, strerror(errno));
-        exit(EXIT_FAILURE);
-    }
+/* Blocks larger than a quarter of a chunk get chunks of their own. */
+void *numa_arena_alloc(numa_arena_t *arena, size_t nbytes) {
+    size_t size_class = numa_arena_class(nbytes);
+    size_t size = (size_t) 1 << (NUMA_ARENA_MIN_SIZE_LOG + size_class);
 
-    thread_pool->threads = malloc(sizeof(pthread_t) * (POOL_SIZE + 1));
-    check_for_successful_alloc(thread_pool->threads);
+    mutex_lock(&arena->mutex);
 
-    for (size_t i = 0; i < POOL_SIZE; i++) {
-        thread_create(&thread_pool->threads[i], NULL, thread_function, NULL);
+    void *block = arena->free[size_class];
+    if (block != NULL) {
+        arena->free[size_class] = *(void **) block;
     }
-    thread_create(&thread_pool->threads[POOL_SIZE], NULL,
-                  thread_signal_handler_function, NULL);
-}
+    else if (size > NUMA_ARENA_CHUNK_SIZE / 4) {
+        size_t chunk_size = (size + NUMA_ARENA_HEADER_SIZE + NUMA_ARENA_CHUNK_SIZE - 1)
+                            / NUMA_ARENA_CHUNK_SIZE * NUMA_ARENA_CHUNK_SIZE;
+        block = (char *) numa_arena_map(arena, chunk_size) + NUMA_ARENA_HEADER_SIZE;
+    }
+    else {
+        if (arena->free_size < size) {
+            char *chunk = (char *) numa_arena_map(arena, NUMA_ARENA_CHUNK_SIZE);
+            arena->free_space = chunk + NUMA_ARENA_HEADER_SIZE;
+            arena->free_size = NUMA_ARENA_CHUNK_SIZE - NUMA_ARENA_HEADER_SIZE;
+        }
 
-int thread_pool_join(thread_pool_t *thread_pool) {
-    void *ret_val;
-    for (size_t i = 0; i < POOL_SIZE; i++) {
-        thread_join(thread_pool->threads[i], &ret_val);
+        block = arena->free_space;
+        arena->free_space += size;
+        arena->free_size -= size;
     }
-    pthread_cancel(thread_pool->threads[POOL_SIZE]);
-    thread_join(thread_pool->threads[POOL_SIZE], &ret_val);
 
-    return 0;
+    mutex_unlock(&arena->mutex);
+
+    return block;
 }
 
-void thread_pool_destroy(thread_pool_t *thread_pool) {
-    queue_destroy(thread_pool->queue);
+void numa_arena_free(numa_arena_t *arena, void *block, size_t nbytes) {
+    size_t size_class = numa_arena_class(nbytes);
 
-    mutex_destroy(&thread_pool->queue_mutex);
-    cond_destroy(&thread_pool->queue_nonempty);
-    if (pthread_key_delete(thread_pool->key_actor_id)) {
-        fprintf(stderr, "%s: pthread_key_delete failed, %d, %s\n",
-                __func__, errno, strerror(errno));
-        exit(EXIT_FAILURE);
+    mutex_lock(&arena->mutex);
+    *(void **) block = arena->free[size_class];
+    arena->free[size_class] = block;
+    mutex_unlock(&arena->mutex);
+}
+
+void numa_arena_destroy(numa_arena_t *arena) {
+    while (arena->chunks != NULL) {
+        numa_chunk_t *chunk = arena->chunks;
+        arena->chunks = chunk->next;
+        munmap(chunk, chunk->size);
     }
 
-    free(thread_pool->threads);
-    free(thread_pool);
+    mutex_destroy(&arena->mutex);
 }
 
+size_t mailbox_max_capacity() {
+    size_t capacity = MAILBOX_INITIAL_CAPACITY;
+    while (capacity < ACTOR_QUEUE_LIMIT) {
+        capacity *= 2;
+    }
 
-int actor_system_init() {
-    sigset_t block_mask;
-    sigemptyset(&block_mask);
-    sigaddset(&block_mask, SIGINT);
-    pthread_sigmask(SIG_BLOCK, &block_mask, NULL);
-    actor_system.sigaction.sa_mask = block_mask;
-    actor_system.sigaction.sa_handler = sigint_handler;
+    return capacity;
+}
 
-    int err;
-    if ((err = sigaction(SIGINT, &actor_system.sigaction, NULL))) {
-        fprintf(stderr, "%s: setting up custom sigaction failed: %d, %s\n",
-                __func__, errno, strerror(errno));
+size_t mailbox_segment_size(size_t capacity) {
+    return sizeof(mailbox_segment_t) + capacity * sizeof(mailbox_slot_t);
+}
 
-        return err;
+mailbox_segment_t *mailbox_segment_create(numa_arena_t *arena, size_t capacity) {
+    mailbox_segment_t *segment;
+    if (arena == NULL) {
+        segment = cache_aligned_alloc(mailbox_segment_size(capacity));
     }
     else {
-        thread_pool_create();
-
-        actor_system.created = true;
-        actor_system.actors_capacity = 1024;
-        actor_system.actors = malloc(
-                actor_system.actors_capacity * sizeof(actor_t *));
-        check_for_successful_alloc(actor_system.actors);
-
-        actor_system.spawned_actors = 0;
-        actor_system.spawning_allowed = true;
-        actor_system.dead_empty_actors = 0;
+        segment = numa_arena_alloc(arena, mailbox_segment_size(capacity));
+    }
+    atomic_init(&segment->enqueue_pos, 0);
+    atomic_init(&segment->dequeue_pos, 0);
+    size_t next_capacity = capacity * 2;
+    if (next_capacity > mailbox_max_capacity()) {
+        next_capacity = mailbox_max_capacity();
+    }
+    atomic_init(&segment->next_capacity, next_capacity);
+    atomic_init(&segment->next, NULL);
+    segment->retired_next = NULL;
+    segment->capacity = capacity;
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(&segment->slots[i].sequence, i);
+    }
 
-        mutex_recursive_init(&actor_system.actors_mutex);
+    return segment;
+}
 
-        return 0;
+void mailbox_segment_destroy(numa_arena_t *arena, mailbox_segment_t *segment) {
+    if (arena == NULL) {
+        free(segment);
+    }
+    else {
+        numa_arena_free(arena, segment, mailbox_segment_size(segment->capacity));
     }
 }
 
-bool can_spawn_actor() {
-    return actor_system.spawning_allowed && actor_system.spawned_actors < CAST_LIMIT;
-}
+typedef struct payload payload_t;
 
-actor_id_t actor_system_spawn_actor(role_t *role) {
-    mutex_lock(&actor_system.actors_mutex);
+/* Payloads of class c hold up to 2^(PAYLOAD_MIN_SIZE_LOG + c) bytes and are
+ * carved out of slabs that are never returned to the system. Larger ones,
+ * of class PAYLOAD_CLASSES, come straight from malloc. */
+struct payload {
+    _Atomic size_t references;
+    size_t size_class;
+    payload_t *next_free;
+    alignas(max_align_t) unsigned char data[];
+};
 
-    if (!can_spawn_actor()) {
-        mutex_unlock(&actor_system.actors_mutex);
+/* Workers and blocking threads keep up to PAYLOAD_CACHE_SIZE free payloads
+ * of each class and exchange half of them with the shared depot when they
+ * run out or have too many. They flush the cache when they exit. Other
+ * threads, which the runtime does not see exit, take and return payloads
+ * at the depot, so that none are left behind in their caches. */
+typedef struct payload_cache {
+    bool enabled;
+    payload_t *free[PAYLOAD_CLASSES];
+    size_t count[PAYLOAD_CLASSES];
+} payload_cache_t;
+
+typedef struct payload_depot {
+    pthread_mutex_t mutex;
+    payload_t *free[PAYLOAD_CLASSES];
+} payload_depot_t;
 
-        return -1;
-    }
-    else {
-        if (actor_system.spawned_actors == actor_system.actors_capacity) {
-            actor_system.actors_capacity *= 2;
-            size_t new_size = actor_system.actors_capacity * sizeof(actor_t *);
-            actor_system.actors = realloc(actor_system.actors, new_size);
-            check_for_successful_alloc(actor_system.actors);
-        }
+payload_depot_t payload_depot = {
+        .mutex = PTHREAD_MUTEX_INITIALIZER
+};
 
-        actor_id_t actor_id = actor_system.spawned_actors;
-        actor_system.actors[actor_id] = actor_create(actor_id, role);
-        actor_system.spawned_actors++;
-        mutex_unlock(&actor_system.actors_mutex);
+_Thread_local payload_cache_t payload_cache;
 
-        return actor_id;
-    }
+size_t payload_size(size_t size_class) {
+    return sizeof(payload_t) + ((size_t) 1 << (PAYLOAD_MIN_SIZE_LOG + size_class));
 }
 
-bool actor_system_legal_actor_id(actor_id_t actor) {
-    mutex_lock(&actor_system.actors_mutex);
-    bool res = 0 <= actor
-               && actor < CAST_LIMIT
-               && (size_t) actor < actor_system.spawned_actors;
-    mutex_unlock(&actor_system.actors_mutex);
+payload_t *payload_of(void *data) {
+    return (payload_t *) ((unsigned char *) data - offsetof(payload_t, data));
+}
 
-    return res;
+/* Called with the depot locked. */
+void payload_depot_grow(size_t size_class) {
+    size_t size = payload_size(size_class);
+    size_t n = PAYLOAD_SLAB_SIZE / size > 0 ? PAYLOAD_SLAB_SIZE / size : 1;
+
+    unsigned char *slab = malloc(n * size);
+    check_for_successful_alloc(slab);
+    for (size_t i = 0; i < n; i++) {
+        payload_t *payload = (payload_t *) (slab + i * size);
+        payload->size_class = size_class;
+        payload->next_free = payload_depot.free[size_class];
+        payload_depot.free[size_class] = payload;
+    }
 }
 
-void actor_system_dispose() {
-    actor_system.created = false;
-    thread_pool_destroy(actor_system.thread_pool);
+payload_t *payload_depot_take(size_t size_class) {
+    mutex_lock(&payload_depot.mutex);
 
-    for (size_t i = 0; i < actor_system.spawned_actors; i++) {
-        actor_destroy(actor_system.actors[i]);
+    if (payload_depot.free[size_class] == NULL) {
+        payload_depot_grow(size_class);
     }
-    free(actor_system.actors);
+    payload_t *payload = payload_depot.free[size_class];
+    payload_depot.free[size_class] = payload->next_free;
 
-    actor_system.spawned_actors = 0;
-    actor_system.dead_empty_actors = 0;
+    mutex_unlock(&payload_depot.mutex);
 
-    mutex_destroy(&actor_system.actors_mutex);
+    return payload;
 }
 
-actor_id_t actor_id_self() {
-    actor_id_t *actor_id = pthread_getspecific(
-            actor_system.thread_pool->key_actor_id);
+void payload_depot_put(payload_t *payload) {
+    mutex_lock(&payload_depot.mutex);
 
-    return *actor_id;
+    payload->next_free = payload_depot.free[payload->size_class];
+    payload_depot.free[payload->size_class] = payload;
+
+    mutex_unlock(&payload_depot.mutex);
 }
 
-int actor_system_create(actor_id_t *actor, role_t *const role) {
-    int err;
-    if ((err = actor_system_init())) {
-        return err;
+void payload_cache_refill(size_t size_class) {
+    mutex_lock(&payload_depot.mutex);
+
+    if (payload_depot.free[size_class] == NULL) {
+        payload_depot_grow(size_class);
+    }
+    while (payload_cache.count[size_class] < PAYLOAD_CACHE_SIZE / 2
+           && payload_depot.free[size_class] != NULL) {
+        payload_t *payload = payload_depot.free[size_class];
+        payload_depot.free[size_class] = payload->next_free;
+        payload->next_free = payload_cache.free[size_class];
+        payload_cache.free[size_class] = payload;
+        payload_cache.count[size_class]++;
+    }
+
+    mutex_unlock(&payload_depot.mutex);
+}
+
+void payload_cache_spill(size_t size_class, size_t keep) {
+    mutex_lock(&payload_depot.mutex);
+
+    while (payload_cache.count[size_class] > keep) {
+        payload_t *payload = payload_cache.free[size_class];
+        payload_cache.free[size_class] = payload->next_free;
+        payload_cache.count[size_class]--;
+        payload->next_free = payload_depot.free[size_class];
+        payload_depot.free[size_class] = payload;
+    }
+
+    mutex_unlock(&payload_depot.mutex);
+}
+
+/* Returns the cached payloads of an exiting thread to the depot. */
+void payload_cache_flush() {
+    payload_cache.enabled = false;
+    for (size_t i = 0; i < PAYLOAD_CLASSES; i++) {
+        payload_cache_spill(i, 0);
+    }
+}
+
+void *message_payload_alloc(size_t nbytes) {
+    size_t size_class = 0;
+    while (size_class < PAYLOAD_CLASSES
+           && ((size_t) 1 << (PAYLOAD_MIN_SIZE_LOG + size_class)) < nbytes) {
+        size_class++;
+    }
+
+    payload_t *payload;
+    if (size_class == PAYLOAD_CLASSES) {
+        payload = malloc(sizeof(payload_t) + nbytes);
+        check_for_successful_alloc(payload);
+        payload->size_class = PAYLOAD_CLASSES;
+    }
+    else if (!payload_cache.enabled) {
+        payload = payload_depot_take(size_class);
     }
     else {
-        *actor = actor_system_spawn_actor(role);
-        if (*actor < 0) {
-            return -1;
+        if (payload_cache.free[size_class] == NULL) {
+            payload_cache_refill(size_class);
+        }
+
+        payload = payload_cache.free[size_class];
+        payload_cache.free[size_class] = payload->next_free;
+        payload_cache.count[size_class]--;
+    }
+
+    atomic_init(&payload->references, 1);
+
+    return payload->data;
+}
+
+void message_payload_retain(void *data) {
+    atomic_fetch_add_explicit(&payload_of(data)->references, 1,
+                              memory_order_relaxed);
+}
+
+void message_payload_release(void *data) {
+    payload_t *payload = payload_of(data);
+    if (atomic_fetch_sub_explicit(&payload->references, 1,
+                                  memory_order_acq_rel) > 1) {
+        return;
+    }
+
+    if (payload->size_class == PAYLOAD_CLASSES) {
+        free(payload);
+    }
+    else if (!payload_cache.enabled) {
+        payload_depot_put(payload);
+    }
+    else {
+        payload->next_free = payload_cache.free[payload->size_class];
+        payload_cache.free[payload->size_class] = payload;
+        if (++payload_cache.count[payload->size_class] > PAYLOAD_CACHE_SIZE) {
+            payload_cache_spill(payload->size_class, PAYLOAD_CACHE_SIZE / 2);
+        }
+    }
+}
+
+void message_release(message_t *message) {
+    if (message->release != NULL) {
+        message->release(message->data);
+    }
+}
+
+/* Copies only the used part of an inline payload. */
+void message_copy(message_t *destination, const message_t *source) {
+    destination->message_type = source->message_type;
+    destination->nbytes = source->nbytes;
+    destination->data = source->data;
+    destination->release = source->release;
+    destination->flags = source->flags;
+    if (source->flags & MSG_FLAG_INLINE) {
+        memcpy(destination->payload, source->payload, source->nbytes);
+    }
+}
+
+/* Fails once the segment is sealed; a full segment gets sealed here. */
+bool mailbox_segment_push(mailbox_segment_t *segment, const message_t *message,
+                          timer_id_t timer) {
+    size_t pos = atomic_load(&segment->enqueue_pos);
+
+    while (!(pos & SEGMENT_SEALED)) {
+        mailbox_slot_t *slot = &segment->slots[pos & (segment->capacity - 1)];
+        size_t sequence = atomic_load_explicit(&slot->sequence,
+                                               memory_order_acquire);
+
+        if (sequence == pos) {
+            if (atomic_compare_exchange_weak(&segment->enqueue_pos, &pos, pos + 1)) {
+                slot->envelope.enqueued_at = stats_enqueue_stamp(pos);
+                slot->envelope.timer = timer;
+                message_copy(&slot->message, message);
+                atomic_store(&slot->sequence, pos + 1);
+
+                return true;
+            }
+        }
+        else if ((ptrdiff_t) (sequence - pos) < 0) {
+            atomic_compare_exchange_weak(&segment->enqueue_pos, &pos,
+                                         pos | SEGMENT_SEALED);
         }
         else {
-            if ((err = actor_send_hello_message(*actor, 0, NULL))) {
-                fprintf(stderr, "%s: failed to send hello\n", __func__);
+            pos = atomic_load(&segment->enqueue_pos);
+        }
+    }
+
+    return false;
+}
+
+/* Claims places for up to n messages at once, or for one if the segment
+ * has less room. Returns 0 once the segment is sealed. */
+size_t mailbox_segment_push_many(mailbox_segment_t *segment,
+                                 const message_t *messages, size_t n) {
+    size_t pos = atomic_load(&segment->enqueue_pos);
+    size_t count = n < segment->capacity ? n : segment->capacity;
+
+    while (count > 1 && !(pos & SEGMENT_SEALED)) {
+        /* The consumer frees slots in order, so the last one is enough. */
+        size_t last = pos + count - 1;
+        mailbox_slot_t *slot = &segment->slots[last & (segment->capacity - 1)];
+        size_t sequence = atomic_load_explicit(&slot->sequence,
+                                               memory_order_acquire);
+
+        if (sequence == last) {
+            if (atomic_compare_exchange_weak(&segment->enqueue_pos, &pos,
+                                             pos + count)) {
+                uint64_t now = 0;
+                for (size_t i = 0; i < count; i++) {
+                    slot = &segment->slots[(pos + i) & (segment->capacity - 1)];
+                    if (stats_enqueue_sampled(pos + i) && now == 0) {
+                        now = clock_nsec();
+                    }
+                    slot->envelope.enqueued_at = stats_enqueue_sampled(pos + i) ? now : 0;
+                    slot->envelope.timer = -1;
+                    message_copy(&slot->message, &messages[i]);
+                    atomic_store(&slot->sequence, pos + i + 1);
+                }
+
+                return count;
             }
+        }
+        else if ((ptrdiff_t) (sequence - last) < 0) {
+            break;
+        }
+        else {
+            pos = atomic_load(&segment->enqueue_pos);
+        }
+    }
 
-            return err;
+    return mailbox_segment_push(segment, &messages[0], -1) ? 1 : 0;
+}
+
+bool mailbox_segment_ready(mailbox_segment_t *segment) {
+    size_t pos = atomic_load_explicit(&segment->dequeue_pos, memory_order_relaxed);
+    mailbox_slot_t *slot = &segment->slots[pos & (segment->capacity - 1)];
+
+    return atomic_load(&slot->sequence) == pos + 1;
+}
+
+/* Whether the segment is sealed and everything claimed in it was consumed. */
+bool mailbox_segment_drained(mailbox_segment_t *segment) {
+    size_t pos = atomic_load_explicit(&segment->dequeue_pos, memory_order_relaxed);
+    size_t enqueue_pos = atomic_load(&segment->enqueue_pos);
+
+    return (enqueue_pos & SEGMENT_SEALED) && (enqueue_pos & ~SEGMENT_SEALED) == pos;
+}
+
+void mailbox_init(mailbox_t *mailbox, size_t limit, numa_arena_t *arena) {
+    atomic_init(&mailbox->state, 0);
+    mailbox->limit = limit;
+    mailbox->arena = arena;
+    atomic_init(&mailbox->waiting, 0);
+    atomic_init(&mailbox->users, 0);
+    atomic_init(&mailbox->tail, NULL);
+    atomic_init(&mailbox->head, NULL);
+    mailbox->retired = NULL;
+    mailbox->peak = 0;
+}
+
+size_t mailbox_count(uint64_t state) {
+    return state & MAILBOX_COUNT_MASK;
+}
+
+bool mailbox_closed(uint64_t state) {
+    return state & MAILBOX_CLOSED;
+}
+
+uint64_t mailbox_generation(uint64_t state) {
+    return state >> MAILBOX_GENERATION_SHIFT;
+}
+
+mailbox_segment_t *mailbox_first_segment(mailbox_t *mailbox) {
+    mailbox_segment_t *segment = atomic_load(&mailbox->tail);
+    if (segment == NULL) {
+        mailbox_segment_t *created = mailbox_segment_create(
+                mailbox->arena, MAILBOX_INITIAL_CAPACITY);
+        if (atomic_compare_exchange_strong(&mailbox->tail, &segment, created)) {
+            atomic_store(&mailbox->head, created);
+            segment = created;
+        }
+        else {
+            mailbox_segment_destroy(mailbox->arena, created);
         }
     }
+
+    return segment;
 }
 
-void actor_system_join(actor_id_t actor) {
-    if (actor_system.created) {
-        if (!actor_system_legal_actor_id(actor)) {
-            fprintf(stderr, "%s: invalid actor id\n", __func__);
+mailbox_segment_t *mailbox_next_segment(mailbox_t *mailbox,
+                                        mailbox_segment_t *segment) {
+    mailbox_segment_t *next = atomic_load(&segment->next);
+    if (next == NULL) {
+        mailbox_segment_t *created = mailbox_segment_create(
+                mailbox->arena, atomic_load(&segment->next_capacity));
+        if (atomic_compare_exchange_strong(&segment->next, &next, created)) {
+            next = created;
         }
         else {
-            thread_pool_join(actor_system.thread_pool);
-            actor_system_dispose();
+            mailbox_segment_destroy(mailbox->arena, created);
         }
     }
+
+    mailbox_segment_t *expected = segment;
+    atomic_compare_exchange_strong(&mailbox->tail, &expected, next);
+
+    return next;
 }
 
-int send_message(actor_id_t actor, message_t message) {
-    if (!actor_system_legal_actor_id(actor)) {
-        return -2;
+void mailbox_push(mailbox_t *mailbox, const message_t *message, timer_id_t timer) {
+    mailbox_segment_t *segment = mailbox_first_segment(mailbox);
+    while (!mailbox_segment_push(segment, message, timer)) {
+        segment = mailbox_next_segment(mailbox, segment);
+    }
+}
+
+void mailbox_push_many(mailbox_t *mailbox, const message_t *messages, size_t n) {
+    mailbox_segment_t *segment = mailbox_first_segment(mailbox);
+    while (n > 0) {
+        size_t pushed = mailbox_segment_push_many(segment, messages, n);
+        if (pushed == 0) {
+            segment = mailbox_next_segment(mailbox, segment);
+        }
+
+        messages += pushed;
+        n -= pushed;
+    }
+}
+
+void mailbox_reclaim(mailbox_t *mailbox) {
+    if (mailbox->retired != NULL
+        && mailbox_count(atomic_load(&mailbox->state)) == 0
+        && atomic_load(&mailbox->users) == 0) {
+        while (mailbox->retired != NULL) {
+            mailbox_segment_t *segment = mailbox->retired;
+            mailbox->retired = segment->retired_next;
+            mailbox_segment_destroy(mailbox->arena, segment);
+        }
+    }
+}
+
+/* Whether the oldest reserved message has already been published. Only
+ * reads the segments, so it may be called by other threads as a user. */
+bool mailbox_ready(mailbox_t *mailbox) {
+    mailbox_segment_t *segment = atomic_load(&mailbox->head);
+    while (segment != NULL) {
+        if (mailbox_segment_ready(segment)) {
+            return true;
+        }
+        else if (!mailbox_segment_drained(segment)) {
+            return false;
+        }
+        segment = atomic_load(&segment->next);
+    }
+
+    return false;
+}
+
+bool mailbox_pop(mailbox_t *mailbox, message_t *message, envelope_t *envelope) {
+    mailbox_segment_t *segment = atomic_load(&mailbox->head);
+    if (segment == NULL) {
+        return false;
+    }
+
+    while (!mailbox_segment_ready(segment)) {
+        mailbox_segment_t *next = atomic_load(&segment->next);
+        if (!mailbox_segment_drained(segment) || next == NULL) {
+            return false;
+        }
+
+        atomic_store(&mailbox->head, next);
+        mailbox_segment_t *expected = segment;
+        atomic_compare_exchange_strong(&mailbox->tail, &expected, next);
+
+        segment->retired_next = mailbox->retired;
+        mailbox->retired = segment;
+
+        segment = next;
+        mailbox->peak = 0;
+    }
+
+    size_t pos = atomic_load_explicit(&segment->dequeue_pos, memory_order_relaxed);
+    mailbox_slot_t *slot = &segment->slots[pos & (segment->capacity - 1)];
+    message_copy(message, &slot->message);
+    if (envelope != NULL) {
+        *envelope = slot->envelope;
+    }
+    atomic_store_explicit(&slot->sequence, pos + segment->capacity,
+                          memory_order_release);
+    atomic_store_explicit(&segment->dequeue_pos, pos + 1, memory_order_relaxed);
+
+    return true;
+}
+
+/* Called by the consumer when the mailbox is empty. A segment that stayed
+ * at most a quarter full since the last call is sealed, so that the next
+ * message goes to a segment half its size. */
+void mailbox_shrink(mailbox_t *mailbox) {
+    mailbox_segment_t *segment = atomic_load(&mailbox->head);
+    if (segment != NULL && segment->capacity > MAILBOX_INITIAL_CAPACITY
+        && mailbox->peak <= segment->capacity / 4) {
+        atomic_store(&segment->next_capacity, segment->capacity / 2);
+        atomic_fetch_or(&segment->enqueue_pos, SEGMENT_SEALED);
+    }
+
+    mailbox->peak = 0;
+    mailbox_reclaim(mailbox);
+}
+
+/* Frees all segments of a mailbox that no producer can reserve in anymore.
+ * Only a previous owner rechecking the mailbox may still read them. */
+void mailbox_clear(mailbox_t *mailbox) {
+    mailbox_segment_t *segment = atomic_exchange(&mailbox->head, NULL);
+    atomic_store(&mailbox->tail, NULL);
+    while (atomic_load(&mailbox->users) > 0) {
+        sched_yield();
+    }
+
+    while (segment != NULL) {
+        mailbox_segment_t *next = atomic_load(&segment->next);
+        mailbox_segment_destroy(mailbox->arena, segment);
+        segment = next;
+    }
+
+    while (mailbox->retired != NULL) {
+        segment = mailbox->retired;
+        mailbox->retired = segment->retired_next;
+        mailbox_segment_destroy(mailbox->arena, segment);
+    }
+
+    mailbox->peak = 0;
+}
+
+/* Releases the messages left undelivered at shutdown. */
+void mailbox_destroy(mailbox_t *mailbox) {
+    message_t message;
+    while (mailbox_pop(mailbox, &message, NULL)) {
+        message_release(&message);
+    }
+
+    mailbox_clear(mailbox);
+}
+
+
+size_t actor_index(actor_id_t actor) {
+    return (uint64_t) actor & (((uint64_t) 1 << ACTOR_INDEX_BITS) - 1);
+}
+
+uint64_t actor_generation(actor_id_t actor) {
+    return (uint64_t) actor >> ACTOR_INDEX_BITS;
+}
+
+numa_arena_t *actor_arena(actor_system_t *system, size_t node) {
+    thread_pool_t *thread_pool = system->thread_pool;
+
+    return thread_pool->numa ? &thread_pool->nodes[node].arena : NULL;
+}
+
+/* The actor and its mailboxes live in the arena of its home node, if
+ * there is one. */
+actor_t *actor_create(actor_system_t *system, actor_id_t actor_id, role_t *role,
+                      size_t node) {
+    numa_arena_t *arena = actor_arena(system, node);
+    actor_t *actor;
+    if (arena == NULL) {
+        actor = cache_aligned_alloc(sizeof(actor_t));
     }
     else {
-        buffer_t *actor_buffer = actor_system.actors[actor]->buffer;
-        pthread_mutex_t *actor_mutex = &actor_system.actors[actor]->mutex;
-        pthread_cond_t *actor_cond = &actor_system.actors[actor]->buffer_space;
+        actor = numa_arena_alloc(arena, sizeof(actor_t));
+    }
+    actor->actor_id = actor_id;
+    actor->system = system;
+    actor->node = node;
+    atomic_init(&actor->scheduled, false);
+    actor->next_scheduled = NULL;
+    actor->next_free = NULL;
+    mailbox_init(&actor->urgent, ACTOR_URGENT_LIMIT, arena);
+    mailbox_init(&actor->mailbox, ACTOR_QUEUE_LIMIT, arena);
+    actor->role = role;
+    actor->stateptr = NULL;
+
+    mutex_recursive_init(&actor->mutex);
+    cond_init(&actor->urgent_space, NULL);
+    cond_init(&actor->buffer_space, NULL);
+    actor->space_waiters = NULL;
+
+    return actor;
+}
+
+/* Gives the actor a new generation, so that ids of its previous incarnation
+ * are rejected, and opens its mailbox. */
+void actor_reuse(actor_t *actor, role_t *role) {
+    uint64_t generation = (actor_generation(actor->actor_id) + 1)
+                          & ACTOR_GENERATION_MASK;
+    actor->actor_id = (actor_id_t) ((generation << ACTOR_INDEX_BITS)
+                                    | actor_index(actor->actor_id));
+    actor->role = role;
+    actor->stateptr = NULL;
+    actor->next_free = NULL;
+    atomic_store(&actor->scheduled, false);
+    atomic_store(&actor->urgent.state, generation << MAILBOX_GENERATION_SHIFT);
+    atomic_store(&actor->mailbox.state, generation << MAILBOX_GENERATION_SHIFT);
+}
+
+bool message_urgent(const message_t *message) {
+    return message->message_type == MSG_GODIE
+           || message->message_type == MSG_SPAWN
+           || message->message_type == MSG_HELLO
+           || (message->flags & MSG_FLAG_URGENT);
+}
+
+/* The lane of the actor a message goes to. */
+mailbox_t *actor_lane(actor_t *actor, const message_t *message) {
+    return message_urgent(message) ? &actor->urgent : &actor->mailbox;
+}
 
-        mutex_lock(actor_mutex);
+/* Whether a sender to the given generation has to wait for room. */
+bool mailbox_full(mailbox_t *mailbox, uint64_t state, uint64_t generation) {
+    return !mailbox_closed(state)
+           && mailbox_generation(state) == generation
+           && mailbox_count(state) >= mailbox->limit;
+}
 
-        if (!actor_system.actors[actor]->alive) {
-            mutex_unlock(actor_mutex);
+/* Reserves places for as many of n messages as fit below limit and returns
+ * how many. Fails with -1 once the actor of the given generation is dead,
+ * and with -3 while the lane holds limit messages. */
+int actor_try_reserve_messages(mailbox_t *mailbox, uint64_t generation,
+                               size_t limit, size_t n) {
+    uint64_t state = atomic_load(&mailbox->state);
 
+    while (true) {
+        if (mailbox_closed(state) || mailbox_generation(state) != generation) {
             return -1;
         }
+        else if (mailbox_count(state) >= limit) {
+            return -3;
+        }
         else {
-            while (buffer_full(actor_buffer)) {
-                cond_wait(actor_cond, actor_mutex);
+            size_t count = limit - mailbox_count(state);
+            if (count > n) {
+                count = n;
             }
 
-            bool schedule_actor = buffer_empty(actor_buffer)
-                                  && !actor_system.actors[actor]->scheduled;
-            buffer_push(actor_buffer, message);
-
-            if (schedule_actor) {
-                actor_schedule_for_execution(actor);
+            if (atomic_compare_exchange_weak(&mailbox->state, &state,
+                                             state + count)) {
+                return (int) count;
             }
+        }
+    }
+}
 
-            mutex_unlock(actor_mutex);
+int actor_try_reserve_message(mailbox_t *mailbox, uint64_t generation, size_t limit) {
+    int reserved = actor_try_reserve_messages(mailbox, generation, limit, 1);
 
-            return 0;
+    return reserved < 0 ? reserved : 0;
+}
+
+void worker_flush_next();
+
+/* Senders to each lane wait on a condition of their own, so that a place
+ * freed in one lane wakes a sender of that lane. */
+pthread_cond_t *actor_lane_space(actor_t *actor, mailbox_t *mailbox) {
+    return mailbox == &actor->urgent ? &actor->urgent_space : &actor->buffer_space;
+}
+
+void actor_wait_for_room(actor_t *actor, mailbox_t *mailbox, uint64_t generation) {
+    worker_flush_next();
+
+    mutex_lock(&actor->mutex);
+    atomic_fetch_add(&mailbox->waiting, 1);
+
+    while (mailbox_full(mailbox, atomic_load(&mailbox->state), generation)) {
+        cond_wait(actor_lane_space(actor, mailbox), &actor->mutex);
+    }
+
+    atomic_fetch_sub(&mailbox->waiting, 1);
+    mutex_unlock(&actor->mutex);
+}
+
+/* Blocks the sender while the lane is full. */
+int actor_reserve_message(actor_t *actor, mailbox_t *mailbox, uint64_t generation) {
+    int err;
+    while ((err = actor_try_reserve_message(mailbox, generation,
+                                            mailbox->limit)) == -3) {
+        actor_wait_for_room(actor, mailbox, generation);
+    }
+
+    return err;
+}
+
+/* Blocks the sender until at least one of n messages fits. */
+int actor_reserve_messages(actor_t *actor, mailbox_t *mailbox,
+                           uint64_t generation, size_t n) {
+    int reserved;
+    while ((reserved = actor_try_reserve_messages(mailbox, generation,
+                                                  mailbox->limit, n)) == -3) {
+        actor_wait_for_room(actor, mailbox, generation);
+    }
+
+    return reserved;
+}
+
+/* Registers the waiter to be notified once the mailbox has room. Fails with
+ * -3 if it was registered, and returns 0 if there is room already. A
+ * registered waiter stays counted in waiting until it is notified. */
+int actor_wait_for_space(actor_t *actor, mailbox_t *mailbox, uint64_t generation,
+                         actor_system_t *system, actor_id_t waiter,
+                         message_type_t notify_type) {
+    int err = 0;
+
+    mutex_lock(&actor->mutex);
+    atomic_fetch_add(&mailbox->waiting, 1);
+
+    if (mailbox_full(mailbox, atomic_load(&mailbox->state), generation)) {
+        space_waiter_t *space_waiter = actor->space_waiters;
+        while (space_waiter != NULL && (space_waiter->system != system
+                                        || space_waiter->actor_id != waiter
+                                        || space_waiter->mailbox != mailbox)) {
+            space_waiter = space_waiter->next;
+        }
+
+        if (space_waiter == NULL) {
+            space_waiter = malloc(sizeof(space_waiter_t));
+            check_for_successful_alloc(space_waiter);
+            space_waiter->system = system;
+            space_waiter->actor_id = waiter;
+            space_waiter->mailbox = mailbox;
+            space_waiter->next = actor->space_waiters;
+            actor->space_waiters = space_waiter;
+        }
+        else {
+            atomic_fetch_sub(&mailbox->waiting, 1);
+        }
+        space_waiter->notify_type = notify_type;
+
+        err = -3;
+    }
+    else {
+        atomic_fetch_sub(&mailbox->waiting, 1);
+    }
+
+    mutex_unlock(&actor->mutex);
+
+    return err;
+}
+
+actor_t *actor_system_actor(actor_system_t *system, actor_id_t actor);
+
+void actor_deliver_message(actor_t *actor, const message_t *message,
+                           timer_id_t timer);
+
+/* Notifications bypass ACTOR_QUEUE_LIMIT, so that the worker sending them
+ * never blocks; there is at most one per waiter and full mailbox. */
+void actor_notify_space_waiter(space_waiter_t *space_waiter, actor_id_t actor_id) {
+    actor_t *waiter = actor_system_actor(space_waiter->system, space_waiter->actor_id);
+    message_t notification = {
+            .message_type = space_waiter->notify_type,
+            .nbytes = sizeof(actor_id_t),
+            .data = (void *) actor_id
+    };
+
+    if (waiter != NULL
+        && actor_try_reserve_message(&waiter->mailbox,
+                                     actor_generation(space_waiter->actor_id),
+                                     MAILBOX_COUNT_MASK) == 0) {
+        actor_deliver_message(waiter, &notification, -1);
+    }
+}
+
+/* Wakes blocked senders and notifies registered waiters. */
+void actor_wake_senders(actor_t *actor) {
+    mutex_lock(&actor->mutex);
+
+    cond_broadcast(&actor->urgent_space);
+    cond_broadcast(&actor->buffer_space);
+
+    space_waiter_t *space_waiters = actor->space_waiters;
+    actor->space_waiters = NULL;
+    for (space_waiter_t *space_waiter = space_waiters; space_waiter != NULL;
+         space_waiter = space_waiter->next) {
+        atomic_fetch_sub(&space_waiter->mailbox->waiting, 1);
+    }
+
+    mutex_unlock(&actor->mutex);
+
+    while (space_waiters != NULL) {
+        space_waiter_t *space_waiter = space_waiters;
+        space_waiters = space_waiter->next;
+        actor_notify_space_waiter(space_waiter, actor->actor_id);
+        free(space_waiter);
+    }
+}
+
+/* Wakes a blocked sender of the lane, and notifies its longest registered
+ * waiter, for a place that has just been freed. */
+void actor_wake_sender(actor_t *actor, mailbox_t *mailbox) {
+    mutex_lock(&actor->mutex);
+
+    cond_signal(actor_lane_space(actor, mailbox));
+
+    space_waiter_t **oldest = NULL;
+    for (space_waiter_t **link = &actor->space_waiters; *link != NULL;
+         link = &(*link)->next) {
+        if ((*link)->mailbox == mailbox) {
+            oldest = link;
+        }
+    }
+
+    space_waiter_t *space_waiter = NULL;
+    if (oldest != NULL) {
+        space_waiter = *oldest;
+        *oldest = space_waiter->next;
+        atomic_fetch_sub(&mailbox->waiting, 1);
+    }
+
+    mutex_unlock(&actor->mutex);
+
+    if (space_waiter != NULL) {
+        actor_notify_space_waiter(space_waiter, actor->actor_id);
+        free(space_waiter);
+    }
+}
+
+/* Every place freed below the limit wakes a waiting sender, so that senders
+ * that do not wait cannot keep taking it from them. All of them are woken
+ * together once the lane drains to half its limit, which every drain of a
+ * full lane has to pass. */
+void actor_release_message(actor_t *actor, mailbox_t *mailbox) {
+    uint64_t state = atomic_fetch_sub(&mailbox->state, 1);
+    if (mailbox_count(state) > mailbox->peak) {
+        mailbox->peak = mailbox_count(state);
+        stats_mailbox_depth(mailbox->peak);
+    }
+
+    size_t count = mailbox_count(state) - 1;
+    if (count < mailbox->limit && atomic_load(&mailbox->waiting) > 0) {
+        if (count == mailbox->limit / 2) {
+            actor_wake_senders(actor);
+        }
+        else {
+            actor_wake_sender(actor, mailbox);
         }
     }
 }
+
+void actor_destroy(actor_t *actor) {
+    while (actor->space_waiters != NULL) {
+        space_waiter_t *space_waiter = actor->space_waiters;
+        actor->space_waiters = space_waiter->next;
+        free(space_waiter);
+    }
+
+    mailbox_destroy(&actor->urgent);
+    mailbox_destroy(&actor->mailbox);
+    mutex_destroy(&actor->mutex);
+    cond_destroy(&actor->urgent_space);
+    cond_destroy(&actor->buffer_space);
+    if (actor_arena(actor->system, actor->node) == NULL) {
+        free(actor);
+    }
+}
+
+
+actor_id_t actor_system_spawn_actor(actor_system_t *system, role_t *role);
+
+int actor_system_send(actor_system_t *system, actor_id_t actor, message_t message);
+
+void actor_schedule_for_execution(actor_t *actor);
+
+/* An idle actor is scheduled once more, so that a worker notices it is
+ * dead and empty. */
+void actor_close(actor_t *actor) {
+    atomic_fetch_or(&actor->urgent.state, MAILBOX_CLOSED);
+    atomic_fetch_or(&actor->mailbox.state, MAILBOX_CLOSED);
+
+    if (atomic_load(&actor->urgent.waiting) > 0
+        || atomic_load(&actor->mailbox.waiting) > 0) {
+        actor_wake_senders(actor);
+    }
+
+    if (!atomic_exchange(&actor->scheduled, true)) {
+        actor_schedule_for_execution(actor);
+    }
+}
+
+int actor_send_hello_message(actor_system_t *system, actor_id_t actor_id,
+                             size_t nbytes, void *data) {
+    message_t hello_message = {
+            .message_type = MSG_HELLO,
+            .nbytes = nbytes,
+            .data = data
+    };
+
+    return actor_system_send(system, actor_id, hello_message);
+}
+
+void timer_wheel_settle(timer_wheel_t *timer_wheel, timer_id_t timer_id);
+
+/* MSG_SPAWN takes its role through data, as the role has to outlive the
+ * message. timer is the periodic timer that delivered the message, or -1. */
+void actor_handle_message(actor_t *actor, message_t *message, timer_id_t timer) {
+    void *data = message->flags & MSG_FLAG_INLINE ? message->payload : message->data;
+
+    if (message->message_type == MSG_SPAWN) {
+        actor_id_t new_actor = actor_system_spawn_actor(actor->system, message->data);
+        if (new_actor < 0) {
+            fprintf(stderr, "%s: failed to spawn a new actor\n", __func__);
+        }
+        else {
+            int err = actor_send_hello_message(actor->system, new_actor,
+                                               sizeof(actor_id_t),
+                                               (void *) actor->actor_id);
+            if (err) {
+                fprintf(stderr,
+                        "%s: failed to send hello to a new actor\n", __func__);
+            }
+        }
+    }
+    else if (message->message_type == MSG_GODIE) {
+        actor_close(actor);
+    }
+    else if ((size_t) message->message_type >= actor->role->nprompts) {
+        fprintf(stderr, "%s: invalid message type\n", __func__);
+    }
+    else if (actor->role->prompts[message->message_type] == NULL) {
+        fprintf(stderr, "%s: no handler for the message type\n", __func__);
+    }
+    else {
+        /* MSG_HELLO is 0, so its handler is the first one. */
+        actor->role->prompts[message->message_type](&actor->stateptr,
+                                                    message->nbytes, data);
+    }
+
+    if (timer >= 0) {
+        timer_wheel_settle(&actor->system->timer_wheel, timer);
+    }
+}
+
+void run_queue_init(run_queue_t *run_queue) {
+    atomic_init(&run_queue->head, 0);
+    atomic_init(&run_queue->tail, 0);
+}
+
+bool run_queue_empty(run_queue_t *run_queue) {
+    return atomic_load(&run_queue->head) == atomic_load(&run_queue->tail);
+}
+
+bool run_queue_push(run_queue_t *run_queue, actor_t *actor) {
+    size_t tail = atomic_load_explicit(&run_queue->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&run_queue->head, memory_order_acquire);
+    if (tail - head == RUN_QUEUE_CAPACITY) {
+        return false;
+    }
+
+    atomic_store_explicit(&run_queue->actors[tail % RUN_QUEUE_CAPACITY], actor,
+                          memory_order_relaxed);
+    atomic_store_explicit(&run_queue->tail, tail + 1, memory_order_release);
+
+    return true;
+}
+
+/* Claims half of the queued actors (rounded up), but no more than max.
+ * The slots are read before the CAS on head, which fails if the owner could
+ * have reused any of them in the meantime. */
+size_t run_queue_claim(run_queue_t *run_queue, actor_t **claimed, size_t max) {
+    while (true) {
+        size_t head = atomic_load_explicit(&run_queue->head, memory_order_acquire);
+        size_t tail = atomic_load_explicit(&run_queue->tail, memory_order_acquire);
+        size_t queued = tail - head;
+        if (queued == 0) {
+            return 0;
+        }
+        else if (queued > RUN_QUEUE_CAPACITY) {
+            continue;
+        }
+
+        size_t n = queued - queued / 2;
+        if (n > max) {
+            n = max;
+        }
+        for (size_t i = 0; i < n; i++) {
+            claimed[i] = atomic_load_explicit(
+                    &run_queue->actors[(head + i) % RUN_QUEUE_CAPACITY],
+                    memory_order_relaxed);
+        }
+
+        if (atomic_compare_exchange_weak_explicit(&run_queue->head, &head, head + n,
+                                                  memory_order_acq_rel,
+                                                  memory_order_relaxed)) {
+            return n;
+        }
+    }
+}
+
+
+void futex_wait(_Atomic uint32_t *word, uint32_t expected) {
+    syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+void futex_wake(_Atomic uint32_t *word, int n) {
+    syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+}
+
+void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+/* Wakes up to n parked workers. Nothing is done while some worker spins,
+ * since the spinner finds the work and, if there is more, notifies again. */
+void thread_pool_notify(thread_pool_t *thread_pool, size_t n) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&thread_pool->spinning, memory_order_relaxed) > 0) {
+        return;
+    }
+
+    size_t sleeping = atomic_load_explicit(&thread_pool->sleeping,
+                                           memory_order_relaxed);
+    if (sleeping > 0) {
+        atomic_fetch_add_explicit(&thread_pool->epoch, 1, memory_order_release);
+        futex_wake(&thread_pool->epoch, (int) (n < sleeping ? n : sleeping));
+    }
+}
+
+bool thread_pool_local_work(thread_pool_t *thread_pool) {
+    for (size_t i = 0; i < thread_pool->nworkers; i++) {
+        if (!run_queue_empty(&thread_pool->workers[i].run_queue)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void injection_queue_push(thread_pool_t *thread_pool, size_t node,
+                          actor_t **actors, size_t n) {
+    numa_node_t *numa_node = &thread_pool->nodes[node];
+    mutex_lock(&numa_node->queue_mutex);
+
+    for (size_t i = 0; i < n; i++) {
+        queue_push(numa_node->queue, actors[i]);
+    }
+    atomic_fetch_add(&numa_node->queue_length, n);
+
+    mutex_unlock(&numa_node->queue_mutex);
+
+    thread_pool_notify(thread_pool, n);
+}
+
+/* Pushes every actor to the injection queue of its home node. */
+void injection_queue_push_home(thread_pool_t *thread_pool, actor_t **actors, size_t n) {
+    if (thread_pool->nnodes == 1) {
+        injection_queue_push(thread_pool, 0, actors, n);
+        return;
+    }
+
+    for (size_t node = 0; node < thread_pool->nnodes; node++) {
+        numa_node_t *numa_node = &thread_pool->nodes[node];
+        size_t pushed = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (actors[i]->node == node) {
+                if (pushed++ == 0) {
+                    mutex_lock(&numa_node->queue_mutex);
+                }
+                queue_push(numa_node->queue, actors[i]);
+            }
+        }
+
+        if (pushed > 0) {
+            atomic_fetch_add(&numa_node->queue_length, pushed);
+            mutex_unlock(&numa_node->queue_mutex);
+        }
+    }
+
+    thread_pool_notify(thread_pool, n);
+}
+
+size_t injection_queue_length(thread_pool_t *thread_pool) {
+    size_t length = 0;
+    for (size_t node = 0; node < thread_pool->nnodes; node++) {
+        length += atomic_load(&thread_pool->nodes[node].queue_length);
+    }
+
+    return length;
+}
+
+void thread_pool_finish(thread_pool_t *thread_pool) {
+    atomic_store(&thread_pool->finished, true);
+    atomic_fetch_add(&thread_pool->epoch, 1);
+    futex_wake(&thread_pool->epoch, INT_MAX);
+}
+
+bool injection_queue_pop(thread_pool_t *thread_pool, size_t node, actor_t **actor) {
+    numa_node_t *numa_node = &thread_pool->nodes[node];
+    if (atomic_load(&numa_node->queue_length) == 0) {
+        return false;
+    }
+
+    mutex_lock(&numa_node->queue_mutex);
+
+    bool popped = !queue_empty(numa_node->queue);
+    if (popped) {
+        *actor = queue_pop(numa_node->queue);
+        atomic_fetch_sub(&numa_node->queue_length, 1);
+    }
+
+    mutex_unlock(&numa_node->queue_mutex);
+
+    return popped;
+}
+
+/* Other nodes are tried after the one given. */
+bool injection_queue_pop_any(thread_pool_t *thread_pool, size_t node, actor_t **actor) {
+    for (size_t i = 0; i < thread_pool->nnodes; i++) {
+        if (injection_queue_pop(thread_pool, (node + i) % thread_pool->nnodes, actor)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+void worker_push(worker_t *worker, actor_t *actor) {
+    thread_pool_t *thread_pool = worker->system->thread_pool;
+
+    while (!run_queue_push(&worker->run_queue, actor)) {
+        actor_t *overflow[RUN_QUEUE_CAPACITY / 2 + 1];
+        size_t n = run_queue_claim(&worker->run_queue, overflow,
+                                   RUN_QUEUE_CAPACITY / 2);
+        if (n > 0) {
+            overflow[n] = actor;
+            injection_queue_push_home(thread_pool, overflow, n + 1);
+
+            return;
+        }
+    }
+
+    thread_pool_notify(thread_pool, 1);
+}
+
+/* Takes the actor in run_next of the victim only once it has waited there
+ * for the grace period, as the victim is likely to take it itself sooner. */
+bool worker_steal_next(worker_t *victim, actor_t **actor) {
+    if (atomic_load_explicit(&victim->run_next, memory_order_acquire) == NULL
+        || clock_nsec() < atomic_load_explicit(&victim->run_next_at,
+                                               memory_order_relaxed)
+                          + RUN_NEXT_GRACE_NSEC) {
+        return false;
+    }
+
+    *actor = atomic_exchange(&victim->run_next, NULL);
+
+    return *actor != NULL;
+}
+
+/* Steals from workers of the node of the thief, or of the other nodes,
+ * from their run queues or, when those are empty, from their run_next. */
+bool worker_steal(worker_t *worker, actor_t **actor, bool same_node) {
+    thread_pool_t *thread_pool = worker->system->thread_pool;
+    actor_t *stolen[RUN_QUEUE_CAPACITY / 2];
+
+    size_t nworkers = thread_pool->nworkers;
+    size_t start = rand_r(&worker->seed) % nworkers;
+    for (size_t i = 0; i < nworkers; i++) {
+        worker_t *victim = &thread_pool->workers[(start + i) % nworkers];
+        if (victim == worker || (victim->node == worker->node) != same_node) {
+            continue;
+        }
+
+        size_t n = run_queue_claim(&victim->run_queue, stolen,
+                                   RUN_QUEUE_CAPACITY / 2);
+        if (n == 0 && worker_steal_next(victim, stolen)) {
+            n = 1;
+        }
+        if (n > 0) {
+            if (CACTI_STATS) {
+                counter_add(&worker->stats.steals, 1);
+                counter_add(&worker->stats.stolen, n);
+            }
+
+            *actor = stolen[0];
+            for (size_t j = 1; j < n; j++) {
+                run_queue_push(&worker->run_queue, stolen[j]);
+            }
+            if (n > 1) {
+                thread_pool_notify(thread_pool, 1);
+            }
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Actors of other nodes are only taken when there is nothing to do on the
+ * node of the worker. */
+bool worker_find_actor(worker_t *worker, actor_t **actor) {
+    thread_pool_t *thread_pool = worker->system->thread_pool;
+
+    if (run_queue_claim(&worker->run_queue, actor, 1) > 0
+        || injection_queue_pop(thread_pool, worker->node, actor)
+        || worker_steal(worker, actor, true)) {
+        return true;
+    }
+    else if (thread_pool->nnodes > 1
+             && (injection_queue_pop_any(thread_pool, worker->node, actor)
+                 || worker_steal(worker, actor, false))) {
+        return true;
+    }
+    else if (atomic_load(&thread_pool->finished)) {
+        *actor = NULL;
+        return true;
+    }
+
+    return false;
+}
+
+/* At most max_spinning workers spin at a time. A worker spins for longer
+ * after spinning paid off and for shorter after it ended up parking. */
+bool worker_spin(worker_t *worker, actor_t **actor) {
+    thread_pool_t *thread_pool = worker->system->thread_pool;
+
+    if (atomic_fetch_add(&thread_pool->spinning, 1) >= thread_pool->max_spinning) {
+        atomic_fetch_sub(&thread_pool->spinning, 1);
+        return false;
+    }
+
+    bool found = false;
+    for (size_t round = 0; round < worker->spin_rounds && !found; round++) {
+        for (size_t i = 0; i < WORKER_SPIN_PAUSES; i++) {
+            cpu_relax();
+        }
+        found = worker_find_actor(worker, actor);
+    }
+
+    atomic_fetch_sub(&thread_pool->spinning, 1);
+
+    if (found) {
+        if (worker->spin_rounds < WORKER_SPIN_ROUNDS) {
+            worker->spin_rounds *= 2;
+        }
+        /* The last spinner hands over to a parked worker if more work
+         * arrived while nobody was being woken. */
+        if (*actor != NULL
+            && (injection_queue_length(thread_pool) > 0
+                || !run_queue_empty(&worker->run_queue))) {
+            thread_pool_notify(thread_pool, 1);
+        }
+    }
+    else if (worker->spin_rounds > 1) {
+        worker->spin_rounds /= 2;
+    }
+
+    return found;
+}
+
+/* A worker reads the epoch and announces itself as sleeping before the
+ * final check for work, so that thread_pool_notify either sees it and bumps
+ * the epoch, making futex_wait return at once, or its push is seen here. */
+bool worker_park(worker_t *worker, actor_t **actor) {
+    thread_pool_t *thread_pool = worker->system->thread_pool;
+
+    uint32_t epoch = atomic_load(&thread_pool->epoch);
+    atomic_fetch_add(&thread_pool->sleeping, 1);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    bool found = worker_find_actor(worker, actor);
+    if (!found && !thread_pool_local_work(thread_pool)) {
+        if (CACTI_STATS) {
+            counter_add(&worker->stats.parks, 1);
+        }
+        futex_wait(&thread_pool->epoch, epoch);
+    }
+
+    atomic_fetch_sub(&thread_pool->sleeping, 1);
+
+    return found;
+}
+
+/* The actor already waiting in run_next goes to the run queue, where idle
+ * workers may steal it. Nobody is woken up for the new one, which the worker
+ * is about to run itself; workers looking for work take it after the grace
+ * period, and it is given away before the thread blocks. */
+void worker_push_next(worker_t *worker, actor_t *actor) {
+    atomic_store_explicit(&worker->run_next_at, clock_nsec(),
+                          memory_order_relaxed);
+    actor_t *previous = atomic_exchange(&worker->run_next, actor);
+    if (previous != NULL) {
+        worker_push(worker, previous);
+    }
+}
+
+/* Called before the calling thread blocks, or runs another handler, so that
+ * the actor in run_next of its worker, which may be the one it waits for,
+ * can be stolen. */
+void worker_flush_next() {
+    if (thread_system == NULL) {
+        return;
+    }
+
+    worker_t *worker = pthread_getspecific(thread_system->thread_pool->key_worker);
+    if (worker == NULL) {
+        return;
+    }
+
+    actor_t *next = atomic_exchange(&worker->run_next, NULL);
+    if (next != NULL) {
+        worker_push(worker, next);
+    }
+}
+
+/* Returns NULL once the thread pool has finished. */
+actor_t *worker_next_actor(worker_t *worker) {
+    thread_pool_t *thread_pool = worker->system->thread_pool;
+    actor_t *actor;
+
+    worker->ticks++;
+    if (worker->ticks % INJECTION_QUEUE_INTERVAL == 0
+        && injection_queue_pop(thread_pool, worker->node, &actor)) {
+        return actor;
+    }
+
+    if (atomic_load_explicit(&worker->run_next, memory_order_relaxed) != NULL
+        && (actor = atomic_exchange(&worker->run_next, NULL)) != NULL) {
+        return actor;
+    }
+
+    while (true) {
+        if (worker_find_actor(worker, &actor)
+            || worker_spin(worker, &actor)
+            || worker_park(worker, &actor)) {
+            return actor;
+        }
+    }
+}
+
+void actor_schedule_for_execution(actor_t *actor) {
+    thread_pool_t *thread_pool = actor->system->thread_pool;
+    worker_t *worker = pthread_getspecific(thread_pool->key_worker);
+    if (CACTI_STATS) {
+        actor->scheduled_at = clock_nsec();
+    }
+    TRACE(actor->system, TRACE_SCHEDULE, actor->actor_id, 0);
+
+    /* An actor goes back to its home node, where its memory lives. One
+     * woken up by another actor runs next, unless others wait in the run
+     * queue already, so that a chain of actors handing messages over cannot
+     * starve them. One yielding waits for its turn. */
+    if (worker == NULL || worker->node != actor->node) {
+        injection_queue_push(thread_pool, actor->node, &actor, 1);
+    }
+    else if (worker->running != NULL && worker->running != actor
+             && run_queue_empty(&worker->run_queue)) {
+        worker_push_next(worker, actor);
+    }
+    else {
+        worker_push(worker, actor);
+    }
+}
+
+/* A worker keeps what fits into its run queue of the actors of its node,
+ * for idle workers to steal, and hands the rest to the injection queues of
+ * their nodes under a single lock per node. */
+void actor_schedule_many(actor_system_t *system, actor_t **actors, size_t n) {
+    thread_pool_t *thread_pool = system->thread_pool;
+    worker_t *worker = pthread_getspecific(thread_pool->key_worker);
+    if (CACTI_STATS) {
+        uint64_t now = clock_nsec();
+        for (size_t i = 0; i < n; i++) {
+            actors[i]->scheduled_at = now;
+        }
+    }
+    for (size_t i = 0; CACTI_TRACE && i < n; i++) {
+        TRACE(system, TRACE_SCHEDULE, actors[i]->actor_id, 0);
+    }
+
+    size_t pushed = 0;
+    if (worker != NULL) {
+        size_t kept = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (actors[i]->node == worker->node
+                && run_queue_push(&worker->run_queue, actors[i])) {
+                pushed++;
+            }
+            else {
+                actors[kept++] = actors[i];
+            }
+        }
+        n = kept;
+    }
+
+    if (n > 0) {
+        injection_queue_push_home(thread_pool, actors, n);
+    }
+    if (pushed > 0) {
+        thread_pool_notify(thread_pool, pushed);
+    }
+}
+
+
+long elapsed_nsec(struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec - start->tv_sec) * 1000000000L
+           + (now.tv_nsec - start->tv_nsec);
+}
+
+bool message_blocking(actor_t *actor, message_t *message) {
+    return (actor->role->flags & ROLE_FLAG_BLOCKING)
+           || (message->flags & MSG_FLAG_BLOCKING);
+}
+
+void blocking_executor_submit(blocking_executor_t *blocking_executor,
+                              actor_t *actor, message_t *message,
+                              envelope_t envelope);
+
+/* Urgent messages are taken first. Returns the lane of the message. */
+mailbox_t *actor_pop_message(actor_t *actor, message_t *message,
+                             envelope_t *envelope) {
+    if (mailbox_pop(&actor->urgent, message, envelope)) {
+        return &actor->urgent;
+    }
+    else if (mailbox_pop(&actor->mailbox, message, envelope)) {
+        return &actor->mailbox;
+    }
+
+    return NULL;
+}
+
+/* Handles up to ACTOR_ACTIVATION_MESSAGES messages, or fewer if they take
+ * longer than ACTOR_ACTIVATION_NSEC, before the actor goes back to the
+ * tail of a run queue. On a worker, the activation is handed over to the
+ * blocking executor at the first blocking message, and false is returned;
+ * the executor then yields the actor itself. */
+bool actor_run(actor_t *actor, bool blocking_thread) {
+    actor_system_t *system = actor->system;
+    pthread_setspecific(system->thread_pool->key_actor_id, &actor->actor_id);
+
+    bool timed = CACTI_STATS || ACTOR_ACTIVATION_NSEC > 0;
+    uint64_t start = timed ? clock_nsec() : 0;
+    uint64_t handler_start = start;
+    if (CACTI_STATS && !blocking_thread) {
+        histogram_record(&thread_stats->schedule_wait, start - actor->scheduled_at);
+    }
+
+    bool handed_over = false;
+    message_t message;
+    envelope_t envelope;
+    mailbox_t *mailbox;
+    for (size_t handled = 0;
+         handled < ACTOR_ACTIVATION_MESSAGES
+         && (mailbox = actor_pop_message(actor, &message, &envelope)) != NULL;
+         handled++) {
+        actor_release_message(actor, mailbox);
+
+        /* An actor woken up by the previous handler would wait for this
+         * one, so it is given to whichever worker is free first. */
+        if (handled > 0 && !blocking_thread) {
+            worker_flush_next();
+        }
+
+        if (!blocking_thread && message_blocking(actor, &message)) {
+            blocking_executor_submit(&system->blocking_executor,
+                                     actor, &message, envelope);
+            handed_over = true;
+            break;
+        }
+
+        stats_queue_wait(handler_start, envelope.enqueued_at);
+
+        const role_t *role = actor->role;
+        TRACE(actor->system, TRACE_DISPATCH_BEGIN, actor->actor_id, message.message_type);
+        actor_handle_message(actor, &message, envelope.timer);
+        message_release(&message);
+        TRACE(actor->system, TRACE_DISPATCH_END, actor->actor_id, message.message_type);
+
+        uint64_t now = timed ? clock_nsec() : 0;
+        stats_handler_time(role, message.message_type, now - handler_start);
+        handler_start = now;
+
+        if (ACTOR_ACTIVATION_NSEC > 0 && now - start >= ACTOR_ACTIVATION_NSEC) {
+            break;
+        }
+    }
+
+    if (CACTI_STATS) {
+        counter_add(&thread_stats->activations, 1);
+        counter_add(&thread_stats->busy_nsec, handler_start - start);
+    }
+
+    return !handed_over;
+}
+
+bool actor_ready(actor_t *actor) {
+    return mailbox_ready(&actor->urgent) || mailbox_ready(&actor->mailbox);
+}
+
+/* Whether both lanes are closed and nothing is reserved in them anymore. */
+bool actor_drained(uint64_t urgent_state, uint64_t state) {
+    return mailbox_closed(urgent_state) && mailbox_count(urgent_state) == 0
+           && mailbox_closed(state) && mailbox_count(state) == 0;
+}
+
+/* A reserved but unpublished message is left to its sender, which
+ * schedules the actor again after publishing it. */
+void actor_yield(actor_t *actor) {
+    actor_system_t *system = actor->system;
+    thread_pool_t *thread_pool = system->thread_pool;
+
+    uint64_t urgent_state = atomic_load(&actor->urgent.state);
+    uint64_t state = atomic_load(&actor->mailbox.state);
+    if (actor_ready(actor)) {
+        actor_schedule_for_execution(actor);
+    }
+    else if (actor_drained(urgent_state, state)) {
+        TRACE(actor->system, TRACE_DEATH, actor->actor_id, 0);
+        mailbox_clear(&actor->urgent);
+        mailbox_clear(&actor->mailbox);
+        actor->stateptr = NULL;
+
+        mutex_lock(&system->actors_mutex);
+
+        actor->next_free = system->free_actors;
+        system->free_actors = actor;
+        system->live_actors--;
+        if (system->live_actors == 0) {
+            thread_pool_finish(thread_pool);
+        }
+
+        mutex_unlock(&system->actors_mutex);
+    }
+    else {
+        if (mailbox_count(urgent_state) == 0) {
+            mailbox_shrink(&actor->urgent);
+        }
+        if (mailbox_count(state) == 0) {
+            mailbox_shrink(&actor->mailbox);
+        }
+
+        atomic_store(&actor->scheduled, false);
+
+        /* From here on another worker may own the mailbox. */
+        atomic_fetch_add(&actor->urgent.users, 1);
+        atomic_fetch_add(&actor->mailbox.users, 1);
+        urgent_state = atomic_load(&actor->urgent.state);
+        state = atomic_load(&actor->mailbox.state);
+        bool ready = actor_ready(actor);
+        atomic_fetch_sub(&actor->mailbox.users, 1);
+        atomic_fetch_sub(&actor->urgent.users, 1);
+
+        if ((ready || actor_drained(urgent_state, state))
+            && !atomic_exchange(&actor->scheduled, true)) {
+            actor_schedule_for_execution(actor);
+        }
+    }
+}
+
+void *thread_function(void *arg) {
+    worker_t *worker = arg;
+    actor_system_t *system = worker->system;
+    thread_system = system;
+    pthread_setspecific(system->thread_pool->key_worker, worker);
+    thread_stats = &worker->stats;
+    payload_cache.enabled = true;
+
+    char index[21];
+    snprintf(index, sizeof(index), "%zu", worker->index);
+    thread_set_name(pthread_self(), system->config.thread_name, index);
+
+    while (true) {
+        actor_t *actor = worker_next_actor(worker);
+
+        if (actor == NULL) {
+            break;
+        }
+
+        worker->running = actor;
+        if (actor_run(actor, false)) {
+            actor_yield(actor);
+        }
+        worker->running = NULL;
+    }
+
+    payload_cache_flush();
+
+    return NULL;
+}
+
+void actor_system_close_actors(actor_system_t *system) {
+    mutex_lock(&system->actors_mutex);
+    system->spawning_allowed = false;
+    mutex_unlock(&system->actors_mutex);
+
+    for (size_t i = 0; i < atomic_load(&system->spawned_actors); i++) {
+        actor_close(actor_system_actor(system, i));
+    }
+}
+
+/* The actors of every system are closed, and the default one is joined. */
+void sigint_handler(int sig) {
+    UNUSED(sig);
+
+    mutex_lock(&systems_mutex);
+    for (actor_system_t *system = systems; system != NULL; system = system->next) {
+        actor_system_close_actors(system);
+    }
+    mutex_unlock(&systems_mutex);
+
+    actor_system_join(0);
+}
+
+void *thread_signal_handler_function(void *arg) {
+    UNUSED(arg);
+
+    int old_type;
+    if (pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, &old_type)) {
+        fprintf(stderr, "%s: pthread_setcanceltype failed, %d, %s\n",
+                __func__, errno, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    sigset_t block_mask;
+    sigemptyset(&block_mask);
+    sigaddset(&block_mask, SIGINT);
+    pthread_sigmask(SIG_UNBLOCK, &block_mask, NULL);
+
+    int sig;
+    if (sigwait(&block_mask, &sig)) {
+        fprintf(stderr, "%s: sigwait failed, %d, %s\n",
+                __func__, errno, strerror(errno));
+    }
+
+    return NULL;
+}
+
+/* Threads running actors get the configured stack size. */
+void actor_thread_attr_init(actor_system_t *system, pthread_attr_t *attr) {
+    thread_attr_init(attr);
+    if (system->config.stack_size > 0
+        && pthread_attr_setstacksize(attr, system->config.stack_size)) {
+        fprintf(stderr, "%s: pthread_attr_setstacksize failed, %d, %s\n",
+                __func__, errno, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+}
+
+void thread_attr_setaffinity(pthread_attr_t *attr, cpu_set_t *cpus) {
+    if (pthread_attr_setaffinity_np(attr, sizeof(cpu_set_t), cpus)) {
+        fprintf(stderr, "%s: pthread_attr_setaffinity_np failed, %d, %s\n",
+                __func__, errno, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* Worker i is pinned to the i-th CPU, modulo their number, of those the
+ * process is allowed to run on. */
+void thread_pool_pin_worker(pthread_attr_t *attr, cpu_set_t *allowed, size_t index) {
+    size_t nth = index % (size_t) CPU_COUNT(allowed);
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, allowed) && nth-- == 0) {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(cpu, &cpus);
+            thread_attr_setaffinity(attr, &cpus);
+
+            return;
+        }
+    }
+}
+
+/* Parses a CPU list like "0-3,8,10-11" into cpus. */
+bool numa_parse_cpulist(const char *list, cpu_set_t *cpus) {
+    CPU_ZERO(cpus);
+    while (*list != '\0' && *list != '\n' && *list != ';') {
+        char *end;
+        unsigned long first = strtoul(list, &end, 10);
+        unsigned long last = first;
+        if (end == list) {
+            return false;
+        }
+        if (*end == '-') {
+            list = end + 1;
+            last = strtoul(list, &end, 10);
+            if (end == list || last < first) {
+                return false;
+            }
+        }
+        for (unsigned long cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET(cpu, cpus);
+        }
+
+        list = *end == ',' ? end + 1 : end;
+    }
+
+    return true;
+}
+
+/* Fills the CPUs of at most NUMA_MAX_NODES nodes, of those the process may
+ * run on, and their ids, or -1 if the topology is simulated. Simulated nodes
+ * without allowed CPUs, and machines without nodes, get all allowed CPUs. */
+size_t numa_topology(const char *simulated, cpu_set_t *allowed,
+                     cpu_set_t *cpus, int *ids) {
+    size_t nnodes = 0;
+    if (simulated != NULL && *simulated != '\0') {
+        for (const char *list = simulated; list != NULL && nnodes < NUMA_MAX_NODES;) {
+            if (numa_parse_cpulist(list, &cpus[nnodes])) {
+                CPU_AND(&cpus[nnodes], &cpus[nnodes], allowed);
+                if (CPU_COUNT(&cpus[nnodes]) == 0) {
+                    cpus[nnodes] = *allowed;
+                }
+                ids[nnodes++] = -1;
+            }
+            list = strchr(list, ';');
+            list = list == NULL ? NULL : list + 1;
+        }
+    }
+    else {
+        for (int node = 0; node < NUMA_MAX_NODES; node++) {
+            char path[64];
+            char list[1024];
+            snprintf(path, sizeof(path),
+                     "/sys/devices/system/node/node%d/cpulist", node);
+            FILE *file = fopen(path, "r");
+            if (file == NULL) {
+                continue;
+            }
+
+            bool parsed = fgets(list, sizeof(list), file) != NULL
+                          && numa_parse_cpulist(list, &cpus[nnodes]);
+            fclose(file);
+            if (!parsed) {
+                continue;
+            }
+
+            CPU_AND(&cpus[nnodes], &cpus[nnodes], allowed);
+            if (CPU_COUNT(&cpus[nnodes]) > 0) {
+                ids[nnodes++] = node;
+            }
+        }
+    }
+
+    if (nnodes == 0) {
+        cpus[0] = *allowed;
+        ids[0] = -1;
+        nnodes = 1;
+    }
+
+    return nnodes;
+}
+
+void thread_pool_create(actor_system_t *system) {
+    const actor_system_config_t *config = &system->config;
+    thread_pool_t *thread_pool = cache_aligned_alloc(sizeof(thread_pool_t));
+    system->thread_pool = thread_pool;
+    thread_pool->nworkers = config->workers;
+    atomic_init(&thread_pool->next_node, 0);
+    atomic_init(&thread_pool->epoch, 0);
+    atomic_init(&thread_pool->sleeping, 0);
+    atomic_init(&thread_pool->spinning, 0);
+    atomic_init(&thread_pool->finished, false);
+
+    /* Spinning only pays off when the notifying thread runs meanwhile. */
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    thread_pool->max_spinning = cpus > 1 ? (thread_pool->nworkers + 1) / 2 : 0;
+
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &allowed)) {
+        fprintf(stderr, "%s: sched_getaffinity failed, %d, %s\n",
+                __func__, errno, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    cpu_set_t node_cpus[NUMA_MAX_NODES];
+    int node_ids[NUMA_MAX_NODES];
+    size_t nnodes = 1;
+    if (config->numa) {
+        nnodes = numa_topology(config->numa_topology, &allowed, node_cpus, node_ids);
+        if (nnodes > thread_pool->nworkers) {
+            nnodes = thread_pool->nworkers;
+        }
+    }
+    thread_pool->numa = nnodes > 1;
+    thread_pool->nnodes = nnodes;
+    thread_pool->nodes = cache_aligned_alloc(sizeof(numa_node_t) * nnodes);
+    for (size_t node = 0; node < nnodes; node++) {
+        numa_node_t *numa_node = &thread_pool->nodes[node];
+        numa_node->cpus = thread_pool->numa ? node_cpus[node] : allowed;
+        numa_node->queue = queue_create();
+        atomic_init(&numa_node->queue_length, 0);
+        mutex_init(&numa_node->queue_mutex, NULL);
+        numa_arena_init(&numa_node->arena, thread_pool->numa ? node_ids[node] : -1,
+                        config->hugepages);
+    }
+
+    if (pthread_key_create(&thread_pool->key_actor_id, NULL)
+        || pthread_key_create(&thread_pool->key_worker, NULL)) {
+        fprintf(stderr, "%s: pthread_key_create failed, %d, %s\n",
+                __func__, errno, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    thread_pool->workers = cache_aligned_alloc(sizeof(worker_t) * thread_pool->nworkers);
+    for (size_t i = 0; i < thread_pool->nworkers; i++) {
+        thread_pool->workers[i].system = system;
+        thread_pool->workers[i].index = i;
+        thread_pool->workers[i].ticks = 0;
+        thread_pool->workers[i].spin_rounds = WORKER_SPIN_ROUNDS;
+        thread_pool->workers[i].node = i * nnodes / thread_pool->nworkers;
+        thread_pool->workers[i].running = NULL;
+        atomic_init(&thread_pool->workers[i].run_next, NULL);
+        atomic_init(&thread_pool->workers[i].run_next_at, 0);
+        thread_pool->workers[i].seed = i + 1;
+        run_queue_init(&thread_pool->workers[i].run_queue);
+        thread_stats_init(&thread_pool->workers[i].stats);
+    }
+
+    thread_pool->threads = malloc(sizeof(pthread_t) * (thread_pool->nworkers + 1));
+    check_for_successful_alloc(thread_pool->threads);
+
+    /* With NUMA placement, workers are kept on the CPUs of their nodes, and
+     * pinned workers are bound round-robin to them. */
+    size_t node_workers[NUMA_MAX_NODES] = {0};
+    for (size_t i = 0; i < thread_pool->nworkers; i++) {
+        size_t node = thread_pool->workers[i].node;
+        pthread_attr_t attr;
+        actor_thread_attr_init(system, &attr);
+        if (config->pin_workers) {
+            thread_pool_pin_worker(&attr, &thread_pool->nodes[node].cpus,
+                                   node_workers[node]++);
+        }
+        else if (thread_pool->numa) {
+            thread_attr_setaffinity(&attr, &thread_pool->nodes[node].cpus);
+        }
+
+        thread_create(&thread_pool->threads[i], &attr, thread_function,
+                      &thread_pool->workers[i]);
+        thread_attr_destroy(&attr);
+    }
+    thread_create(&thread_pool->threads[thread_pool->nworkers], NULL,
+                  thread_signal_handler_function, NULL);
+}
+
+/* Every worker exits once thread_pool_finish has been called. */
+int thread_pool_join(thread_pool_t *thread_pool) {
+    void *ret_val;
+    for (size_t i = 0; i < thread_pool->nworkers; i++) {
+        thread_join(thread_pool->threads[i], &ret_val);
+    }
+    pthread_cancel(thread_pool->threads[thread_pool->nworkers]);
+    thread_join(thread_pool->threads[thread_pool->nworkers], &ret_val);
+
+    return 0;
+}
+
+void thread_pool_destroy(thread_pool_t *thread_pool) {
+    for (size_t node = 0; node < thread_pool->nnodes; node++) {
+        queue_destroy(thread_pool->nodes[node].queue);
+        mutex_destroy(&thread_pool->nodes[node].queue_mutex);
+        numa_arena_destroy(&thread_pool->nodes[node].arena);
+    }
+    free(thread_pool->nodes);
+
+    if (pthread_key_delete(thread_pool->key_actor_id)
+        || pthread_key_delete(thread_pool->key_worker)) {
+        fprintf(stderr, "%s: pthread_key_delete failed, %d, %s\n",
+                __func__, errno, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t i = 0; i < thread_pool->nworkers; i++) {
+        thread_stats_destroy(&thread_pool->workers[i].stats);
+    }
+    free(thread_pool->workers);
+    free(thread_pool->threads);
+    free(thread_pool);
+}
+
+
+void timer_wheel_init(actor_system_t *system, timer_wheel_t *timer_wheel);
+
+void blocking_executor_init(actor_system_t *system,
+                            blocking_executor_t *blocking_executor);
+
+int actor_system_init(actor_system_t *system, const actor_system_config_t *config) {
+    system->config = *config;
+    if (system->config.workers == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        system->config.workers = cpus > 0 ? (size_t) cpus : 1;
+    }
+
+    sigset_t block_mask;
+    sigemptyset(&block_mask);
+    sigaddset(&block_mask, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &block_mask, NULL);
+    system->sigaction.sa_mask = block_mask;
+    system->sigaction.sa_handler = sigint_handler;
+
+    int err;
+    if ((err = sigaction(SIGINT, &system->sigaction, NULL))) {
+        fprintf(stderr, "%s: setting up custom sigaction failed: %d, %s\n",
+                __func__, errno, strerror(errno));
+
+        return err;
+    }
+    else {
+        if (CACTI_TRACE) {
+            trace_init(&system->trace);
+        }
+
+        system->created = true;
+        for (size_t i = 0; i < ACTOR_TABLE_SEGMENTS; i++) {
+            system->actors[i] = NULL;
+        }
+        atomic_store(&system->spawned_actors, 0);
+        system->spawning_allowed = true;
+        system->free_actors = NULL;
+        system->live_actors = 0;
+
+        mutex_recursive_init(&system->actors_mutex);
+
+        system->groups = NULL;
+        system->ngroups = 0;
+        system->groups_capacity = 0;
+        mutex_init(&system->groups_mutex, NULL);
+
+        thread_pool_create(system);
+        timer_wheel_init(system, &system->timer_wheel);
+        blocking_executor_init(system, &system->blocking_executor);
+
+        mutex_lock(&systems_mutex);
+        system->next = systems;
+        systems = system;
+        mutex_unlock(&systems_mutex);
+
+        return 0;
+    }
+}
+
+size_t actor_table_segment_size(size_t segment) {
+    return (size_t) 1 << (ACTOR_TABLE_FIRST_SEGMENT_LOG + segment);
+}
+
+void actor_table_position(size_t index, size_t *segment, size_t *offset) {
+    size_t shifted = (index >> ACTOR_TABLE_FIRST_SEGMENT_LOG) + 1;
+    *segment = sizeof(size_t) * 8 - 1 - __builtin_clzl(shifted);
+    *offset = index + actor_table_segment_size(0) - actor_table_segment_size(*segment);
+}
+
+bool can_spawn_actor(actor_system_t *system) {
+    return system->spawning_allowed
+           && (system->free_actors != NULL
+               || atomic_load(&system->spawned_actors) < CAST_LIMIT);
+}
+
+/* Actors spawned by workers share their node, others are spread over the
+ * nodes. A reused actor keeps the node of its memory. */
+size_t actor_system_home_node(actor_system_t *system) {
+    thread_pool_t *thread_pool = system->thread_pool;
+    worker_t *worker = pthread_getspecific(thread_pool->key_worker);
+    if (worker != NULL) {
+        return worker->node;
+    }
+
+    return atomic_fetch_add(&thread_pool->next_node, 1) % thread_pool->nnodes;
+}
+
+/* Spawns up to n actors under a single lock, reusing dead ones first, and
+ * returns how many were spawned. */
+size_t actor_system_spawn_actors(actor_system_t *system, role_t *role,
+                                 actor_t **actors, size_t n) {
+    size_t spawned = 0;
+    mutex_lock(&system->actors_mutex);
+
+    while (spawned < n && can_spawn_actor(system)) {
+        actor_t *actor;
+        if (system->free_actors != NULL) {
+            actor = system->free_actors;
+            system->free_actors = actor->next_free;
+            actor_reuse(actor, role);
+        }
+        else {
+            actor_id_t actor_id = atomic_load(&system->spawned_actors);
+            size_t segment, offset;
+            actor_table_position(actor_id, &segment, &offset);
+
+            if (system->actors[segment] == NULL) {
+                system->actors[segment] = malloc(
+                        actor_table_segment_size(segment) * sizeof(actor_t *));
+                check_for_successful_alloc(system->actors[segment]);
+            }
+
+            actor = actor_create(system, actor_id, role,
+                                 actor_system_home_node(system));
+            system->actors[segment][offset] = actor;
+            atomic_store_explicit(&system->spawned_actors, actor_id + 1,
+                                  memory_order_release);
+        }
+
+        actors[spawned++] = actor;
+    }
+    system->live_actors += spawned;
+
+    mutex_unlock(&system->actors_mutex);
+
+    for (size_t i = 0; CACTI_TRACE && i < spawned; i++) {
+        TRACE(system, TRACE_SPAWN, actors[i]->actor_id, 0);
+    }
+
+    return spawned;
+}
+
+actor_id_t actor_system_spawn_actor(actor_system_t *system, role_t *role) {
+    actor_t *actor;
+
+    return actor_system_spawn_actors(system, role, &actor, 1) == 1
+           ? actor->actor_id : -1;
+}
+
+/* Ids of dead actors whose entries have been reused stay legal; messages
+ * sent to them are rejected by the generation check. */
+bool actor_system_legal_actor_id(actor_system_t *system, actor_id_t actor) {
+    return 0 <= actor
+           && actor_index(actor) < CAST_LIMIT
+           && actor_index(actor) < atomic_load_explicit(&system->spawned_actors,
+                                                         memory_order_acquire);
+}
+
+/* Returns NULL for an id that does not name a table entry. */
+actor_t *actor_system_actor(actor_system_t *system, actor_id_t actor) {
+    if (!actor_system_legal_actor_id(system, actor)) {
+        return NULL;
+    }
+
+    size_t segment, offset;
+    actor_table_position(actor_index(actor), &segment, &offset);
+
+    return system->actors[segment][offset];
+}
+
+uint64_t timer_wheel_clock(timer_wheel_t *timer_wheel) {
+    return (uint64_t) elapsed_nsec(&timer_wheel->start) / TIMER_TICK_NSEC;
+}
+
+/* Only a cascade may link an entry into the slot of the current tick,
+ * which is expired right after it. */
+void timer_wheel_link(timer_wheel_t *timer_wheel, timer_entry_t *timer,
+                      bool cascading) {
+    if (timer->expiry < timer_wheel->now + !cascading) {
+        timer->expiry = timer_wheel->now + !cascading;
+    }
+
+    /* Entries beyond the range of the wheel wait in the farthest slot of
+     * the top level and are placed again when it is cascaded. */
+    uint64_t delta = timer->expiry - timer_wheel->now;
+    uint64_t expiry = timer->expiry;
+    size_t level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1
+           && delta >> (TIMER_WHEEL_SLOTS_LOG * (level + 1)) != 0) {
+        level++;
+    }
+    if (delta >> (TIMER_WHEEL_SLOTS_LOG * TIMER_WHEEL_LEVELS) != 0) {
+        expiry = timer_wheel->now
+                 + ((uint64_t) 1 << (TIMER_WHEEL_SLOTS_LOG * TIMER_WHEEL_LEVELS)) - 1;
+    }
+
+    size_t slot = (expiry >> (TIMER_WHEEL_SLOTS_LOG * level)) & (TIMER_WHEEL_SLOTS - 1);
+    timer->slot = &timer_wheel->slots[level][slot];
+    timer->prev = NULL;
+    timer->next = *timer->slot;
+    if (timer->next != NULL) {
+        timer->next->prev = timer;
+    }
+    *timer->slot = timer;
+}
+
+void timer_wheel_unlink(timer_entry_t *timer) {
+    if (timer->prev != NULL) {
+        timer->prev->next = timer->next;
+    }
+    else {
+        *timer->slot = timer->next;
+    }
+    if (timer->next != NULL) {
+        timer->next->prev = timer->prev;
+    }
+}
+
+void timer_wheel_disarm(timer_wheel_t *timer_wheel, timer_entry_t *timer) {
+    timer->armed = false;
+    timer->next = timer_wheel->free_timers;
+    timer_wheel->free_timers = timer;
+    timer_wheel->armed--;
+}
+
+/* Timer messages bypass ACTOR_QUEUE_LIMIT, so that the timer thread never
+ * blocks; there is at most one per armed timer, as a periodic timer does not
+ * deliver again until its message has been handled. */
+bool timer_wheel_deliver(timer_wheel_t *timer_wheel, timer_entry_t *timer) {
+    actor_t *target = actor_system_actor(timer_wheel->system, timer->actor);
+    if (target == NULL
+        || actor_try_reserve_message(actor_lane(target, &timer->message),
+                                     actor_generation(timer->actor),
+                                     MAILBOX_COUNT_MASK)) {
+        return false;
+    }
+
+    timer_id_t timer_id = -1;
+    if (timer->period > 0) {
+        if (timer->message.release != NULL) {
+            message_payload_retain(timer->message.data);
+        }
+        timer->in_flight = true;
+        timer_id = timer->timer_id;
+    }
+    actor_deliver_message(target, &timer->message, timer_id);
+
+    return true;
+}
+
+void timer_wheel_expire(timer_wheel_t *timer_wheel, timer_entry_t *timers) {
+    while (timers != NULL) {
+        timer_entry_t *timer = timers;
+        timers = timer->next;
+
+        if (timer->in_flight) {
+            timer->expiry += timer->period;
+            timer_wheel_link(timer_wheel, timer, false);
+        }
+        else if (!timer_wheel_deliver(timer_wheel, timer)) {
+            message_release(&timer->message);
+            timer_wheel_disarm(timer_wheel, timer);
+        }
+        else if (timer->period > 0) {
+            timer->expiry += timer->period;
+            timer_wheel_link(timer_wheel, timer, false);
+        }
+        else {
+            timer_wheel_disarm(timer_wheel, timer);
+        }
+    }
+}
+
+void timer_wheel_tick(timer_wheel_t *timer_wheel) {
+    timer_wheel->now++;
+
+    if ((timer_wheel->now & (TIMER_WHEEL_SLOTS - 1)) == 0) {
+        for (size_t level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+            size_t slot = (timer_wheel->now >> (TIMER_WHEEL_SLOTS_LOG * level))
+                          & (TIMER_WHEEL_SLOTS - 1);
+            timer_entry_t *timers = timer_wheel->slots[level][slot];
+            timer_wheel->slots[level][slot] = NULL;
+
+            while (timers != NULL) {
+                timer_entry_t *timer = timers;
+                timers = timer->next;
+                timer_wheel_link(timer_wheel, timer, true);
+            }
+
+            if (slot != 0) {
+                break;
+            }
+        }
+    }
+
+    size_t slot = timer_wheel->now & (TIMER_WHEEL_SLOTS - 1);
+    timer_entry_t *timers = timer_wheel->slots[0][slot];
+    timer_wheel->slots[0][slot] = NULL;
+    timer_wheel_expire(timer_wheel, timers);
+}
+
+/* Ticks until the next non-empty slot of level 0, or until level 0 wraps
+ * around and the level above has to be cascaded. */
+uint64_t timer_wheel_next_delay(timer_wheel_t *timer_wheel) {
+    uint64_t delay = 1;
+    while (((timer_wheel->now + delay) & (TIMER_WHEEL_SLOTS - 1)) != 0
+           && timer_wheel->slots[0][(timer_wheel->now + delay)
+                                    & (TIMER_WHEEL_SLOTS - 1)] == NULL) {
+        delay++;
+    }
+
+    return delay;
+}
+
+void *timer_wheel_thread_function(void *arg) {
+    timer_wheel_t *timer_wheel = arg;
+    thread_system = timer_wheel->system;
+    thread_set_name(pthread_self(), thread_system->config.thread_name, "timer");
+
+    mutex_lock(&timer_wheel->mutex);
+
+    while (!timer_wheel->finished) {
+        uint64_t clock = timer_wheel_clock(timer_wheel);
+        while (timer_wheel->now < clock) {
+            timer_wheel_tick(timer_wheel);
+        }
+
+        if (timer_wheel->armed == 0) {
+            cond_wait(&timer_wheel->changed, &timer_wheel->mutex);
+        }
+        else {
+            uint64_t nsec = (timer_wheel->now + timer_wheel_next_delay(timer_wheel))
+                            * TIMER_TICK_NSEC;
+            struct timespec deadline = {
+                    .tv_sec = timer_wheel->start.tv_sec + (time_t) (nsec / 1000000000L),
+                    .tv_nsec = timer_wheel->start.tv_nsec + (long) (nsec % 1000000000L)
+            };
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+
+            cond_timedwait(&timer_wheel->changed, &timer_wheel->mutex, &deadline);
+        }
+    }
+
+    mutex_unlock(&timer_wheel->mutex);
+
+    return NULL;
+}
+
+void timer_wheel_init(actor_system_t *system, timer_wheel_t *timer_wheel) {
+    timer_wheel->system = system;
+    mutex_init(&timer_wheel->mutex, NULL);
+
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    cond_init(&timer_wheel->changed, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+
+    timer_wheel->finished = false;
+    clock_gettime(CLOCK_MONOTONIC, &timer_wheel->start);
+    timer_wheel->now = 0;
+    timer_wheel->armed = 0;
+    memset(timer_wheel->slots, 0, sizeof(timer_wheel->slots));
+    timer_wheel->timers = NULL;
+    timer_wheel->ntimers = 0;
+    timer_wheel->timers_capacity = 0;
+    timer_wheel->free_timers = NULL;
+
+    thread_create(&timer_wheel->thread, NULL, timer_wheel_thread_function,
+                  timer_wheel);
+}
+
+/* Messages of timers still armed are released. */
+void timer_wheel_destroy(timer_wheel_t *timer_wheel) {
+    mutex_lock(&timer_wheel->mutex);
+    timer_wheel->finished = true;
+    cond_signal(&timer_wheel->changed);
+    mutex_unlock(&timer_wheel->mutex);
+
+    thread_join(timer_wheel->thread, NULL);
+
+    for (size_t i = 0; i < timer_wheel->ntimers; i++) {
+        if (timer_wheel->timers[i]->armed) {
+            message_release(&timer_wheel->timers[i]->message);
+        }
+        free(timer_wheel->timers[i]);
+    }
+    free(timer_wheel->timers);
+
+    mutex_destroy(&timer_wheel->mutex);
+    cond_destroy(&timer_wheel->changed);
+}
+
+/* Called with the wheel locked. */
+timer_entry_t *timer_wheel_timer(timer_wheel_t *timer_wheel, timer_id_t timer_id) {
+    size_t index = (uint64_t) timer_id & (((uint64_t) 1 << TIMER_INDEX_BITS) - 1);
+    if (timer_id < 0 || index >= timer_wheel->ntimers
+        || timer_wheel->timers[index]->timer_id != timer_id
+        || !timer_wheel->timers[index]->armed) {
+        return NULL;
+    }
+
+    return timer_wheel->timers[index];
+}
+
+timer_id_t timer_wheel_arm(timer_wheel_t *timer_wheel, actor_id_t actor,
+                           message_t message, uint64_t delay, uint64_t period) {
+    mutex_lock(&timer_wheel->mutex);
+
+    timer_entry_t *timer = timer_wheel->free_timers;
+    if (timer != NULL) {
+        timer_wheel->free_timers = timer->next;
+        uint64_t generation = ((uint64_t) timer->timer_id >> TIMER_INDEX_BITS) + 1;
+        timer->timer_id = (timer_id_t) (
+                ((generation << TIMER_INDEX_BITS)
+                 | ((uint64_t) timer->timer_id & (((uint64_t) 1 << TIMER_INDEX_BITS) - 1)))
+                & (uint64_t) LONG_MAX);
+    }
+    else {
+        if (timer_wheel->ntimers == timer_wheel->timers_capacity) {
+            timer_wheel->timers_capacity = timer_wheel->timers_capacity == 0
+                                           ? 16 : timer_wheel->timers_capacity * 2;
+            timer_wheel->timers = realloc(
+                    timer_wheel->timers,
+                    timer_wheel->timers_capacity * sizeof(timer_entry_t *));
+            check_for_successful_alloc(timer_wheel->timers);
+        }
+
+        timer = malloc(sizeof(timer_entry_t));
+        check_for_successful_alloc(timer);
+        timer->timer_id = (timer_id_t) timer_wheel->ntimers;
+        timer_wheel->timers[timer_wheel->ntimers++] = timer;
+    }
+
+    timer->expiry = timer_wheel_clock(timer_wheel) + delay;
+    timer->period = period;
+    timer->actor = actor;
+    timer->message = message;
+    timer->armed = true;
+    timer->in_flight = false;
+    timer_wheel->armed++;
+    timer_wheel_link(timer_wheel, timer, false);
+
+    cond_signal(&timer_wheel->changed);
+
+    timer_id_t timer_id = timer->timer_id;
+    mutex_unlock(&timer_wheel->mutex);
+
+    return timer_id;
+}
+
+/* The message of a periodic timer has been handled, so the timer may deliver
+ * it again. */
+void timer_wheel_settle(timer_wheel_t *timer_wheel, timer_id_t timer_id) {
+    mutex_lock(&timer_wheel->mutex);
+
+    timer_entry_t *timer = timer_wheel_timer(timer_wheel, timer_id);
+    if (timer != NULL) {
+        timer->in_flight = false;
+    }
+
+    mutex_unlock(&timer_wheel->mutex);
+}
+
+void blocking_job_run(blocking_job_t *blocking_job) {
+    actor_t *actor = blocking_job->actor;
+
+    pthread_setspecific(actor->system->thread_pool->key_actor_id, &actor->actor_id);
+    const role_t *role = actor->role;
+    uint64_t start = CACTI_STATS ? clock_nsec() : 0;
+    stats_queue_wait(start, blocking_job->envelope.enqueued_at);
+    TRACE(actor->system, TRACE_DISPATCH_BEGIN, actor->actor_id, blocking_job->message.message_type);
+    actor_handle_message(actor, &blocking_job->message,
+                         blocking_job->envelope.timer);
+    message_release(&blocking_job->message);
+    TRACE(actor->system, TRACE_DISPATCH_END, actor->actor_id, blocking_job->message.message_type);
+    if (CACTI_STATS) {
+        stats_handler_time(role, blocking_job->message.message_type,
+                           clock_nsec() - start);
+    }
+
+    actor_run(actor, true);
+    actor_yield(actor);
+}
+
+/* The statistics of a blocking thread are listed in the executor while it
+ * runs, and added to retired_stats once it exits. */
+void *blocking_thread_function(void *arg) {
+    blocking_executor_t *blocking_executor = arg;
+    thread_system = blocking_executor->system;
+    thread_set_name(pthread_self(), thread_system->config.thread_name, "blocking");
+
+    thread_stats_t stats;
+    thread_stats_init(&stats);
+    thread_stats = &stats;
+    payload_cache.enabled = true;
+
+    mutex_lock(&blocking_executor->mutex);
+
+    stats.next = blocking_executor->thread_stats;
+    blocking_executor->thread_stats = &stats;
+
+    while (true) {
+        bool timed_out = false;
+        while (blocking_executor->first == NULL && !blocking_executor->finished
+               && !timed_out) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+            deadline.tv_sec += BLOCKING_IDLE_NSEC / 1000000000L;
+            deadline.tv_nsec += BLOCKING_IDLE_NSEC % 1000000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+
+            blocking_executor->idle++;
+            timed_out = !cond_timedwait(&blocking_executor->job_available,
+                                        &blocking_executor->mutex, &deadline);
+            blocking_executor->idle--;
+        }
+
+        if (blocking_executor->first == NULL) {
+            break;
+        }
+
+        blocking_job_t *blocking_job = blocking_executor->first;
+        blocking_executor->first = blocking_job->next;
+        if (blocking_executor->first == NULL) {
+            blocking_executor->last = NULL;
+        }
+        blocking_executor->jobs--;
+
+        mutex_unlock(&blocking_executor->mutex);
+
+        blocking_job_run(blocking_job);
+        free(blocking_job);
+
+        mutex_lock(&blocking_executor->mutex);
+    }
+
+    mutex_unlock(&blocking_executor->mutex);
+    payload_cache_flush();
+    mutex_lock(&blocking_executor->mutex);
+
+    thread_stats_t **link = &blocking_executor->thread_stats;
+    while (*link != &stats) {
+        link = &(*link)->next;
+    }
+    *link = stats.next;
+    thread_stats_merge(&blocking_executor->retired_stats, &stats);
+    thread_stats = NULL;
+    thread_stats_destroy(&stats);
+
+    blocking_executor->threads--;
+    if (blocking_executor->threads == 0) {
+        cond_broadcast(&blocking_executor->threads_exited);
+    }
+
+    mutex_unlock(&blocking_executor->mutex);
+
+    return NULL;
+}
+
+void blocking_executor_init(actor_system_t *system,
+                            blocking_executor_t *blocking_executor) {
+    blocking_executor->system = system;
+    mutex_init(&blocking_executor->mutex, NULL);
+
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    cond_init(&blocking_executor->job_available, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+    cond_init(&blocking_executor->threads_exited, NULL);
+
+    blocking_executor->first = NULL;
+    blocking_executor->last = NULL;
+    blocking_executor->jobs = 0;
+    blocking_executor->threads = 0;
+    blocking_executor->idle = 0;
+    blocking_executor->finished = false;
+    blocking_executor->thread_stats = NULL;
+    thread_stats_init(&blocking_executor->retired_stats);
+}
+
+/* Every actor is dead by now, so no job is left. */
+void blocking_executor_destroy(blocking_executor_t *blocking_executor) {
+    mutex_lock(&blocking_executor->mutex);
+
+    blocking_executor->finished = true;
+    cond_broadcast(&blocking_executor->job_available);
+    while (blocking_executor->threads > 0) {
+        cond_wait(&blocking_executor->threads_exited, &blocking_executor->mutex);
+    }
+
+    mutex_unlock(&blocking_executor->mutex);
+
+    mutex_destroy(&blocking_executor->mutex);
+    cond_destroy(&blocking_executor->job_available);
+    cond_destroy(&blocking_executor->threads_exited);
+    thread_stats_destroy(&blocking_executor->retired_stats);
+}
+
+void blocking_executor_submit(blocking_executor_t *blocking_executor,
+                              actor_t *actor, message_t *message,
+                              envelope_t envelope) {
+    blocking_job_t *blocking_job = malloc(sizeof(blocking_job_t));
+    check_for_successful_alloc(blocking_job);
+    blocking_job->actor = actor;
+    message_copy(&blocking_job->message, message);
+    blocking_job->envelope = envelope;
+    blocking_job->next = NULL;
+
+    mutex_lock(&blocking_executor->mutex);
+
+    if (blocking_executor->last == NULL) {
+        blocking_executor->first = blocking_job;
+    }
+    else {
+        blocking_executor->last->next = blocking_job;
+    }
+    blocking_executor->last = blocking_job;
+    blocking_executor->jobs++;
+
+    if (blocking_executor->jobs <= blocking_executor->idle) {
+        cond_signal(&blocking_executor->job_available);
+    }
+    else if (blocking_executor->threads < BLOCKING_POOL_LIMIT) {
+        pthread_attr_t attr;
+        actor_thread_attr_init(blocking_executor->system, &attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+        pthread_t thread;
+        thread_create(&thread, &attr, blocking_thread_function, blocking_executor);
+        thread_attr_destroy(&attr);
+
+        blocking_executor->threads++;
+    }
+
+    mutex_unlock(&blocking_executor->mutex);
+}
+
+group_t *group_create(const char *name) {
+    group_t *group = malloc(sizeof(group_t));
+    check_for_successful_alloc(group);
+    group->name = strdup(name);
+    check_for_successful_alloc(group->name);
+    mutex_init(&group->mutex, NULL);
+    group->members = NULL;
+    group->nmembers = 0;
+    group->capacity = 0;
+
+    return group;
+}
+
+void group_destroy(group_t *group) {
+    mutex_destroy(&group->mutex);
+    free(group->members);
+    free(group->name);
+    free(group);
+}
+
+/* Returns NULL for an id that does not name a group. */
+group_t *actor_system_find_group(actor_system_t *system, group_id_t group_id) {
+    group_t *group = NULL;
+
+    mutex_lock(&system->groups_mutex);
+    if (0 <= group_id && (size_t) group_id < system->ngroups) {
+        group = system->groups[group_id];
+    }
+    mutex_unlock(&system->groups_mutex);
+
+    return group;
+}
+
+void actor_system_dispose(actor_system_t *system) {
+    mutex_lock(&systems_mutex);
+    actor_system_t **link = &systems;
+    while (*link != system) {
+        link = &(*link)->next;
+    }
+    *link = system->next;
+    mutex_unlock(&systems_mutex);
+
+    system->created = false;
+    system->spawning_allowed = false;
+    timer_wheel_destroy(&system->timer_wheel);
+    blocking_executor_destroy(&system->blocking_executor);
+    if (CACTI_TRACE) {
+        trace_dump(&system->trace, system->config.trace_path);
+    }
+
+    /* Actors may live in the arenas of the thread pool. */
+    for (size_t i = 0; i < atomic_load(&system->spawned_actors); i++) {
+        actor_destroy(actor_system_actor(system, i));
+    }
+    for (size_t i = 0; i < ACTOR_TABLE_SEGMENTS; i++) {
+        free(system->actors[i]);
+    }
+    thread_pool_destroy(system->thread_pool);
+
+    atomic_store(&system->spawned_actors, 0);
+    system->free_actors = NULL;
+    system->live_actors = 0;
+
+    mutex_destroy(&system->actors_mutex);
+
+    for (size_t i = 0; i < system->ngroups; i++) {
+        group_destroy(system->groups[i]);
+    }
+    free(system->groups);
+    system->groups = NULL;
+    system->ngroups = 0;
+    system->groups_capacity = 0;
+
+    mutex_destroy(&system->groups_mutex);
+}
+
+actor_id_t actor_id_self() {
+    actor_id_t *actor_id = pthread_getspecific(
+            actor_system_self()->thread_pool->key_actor_id);
+
+    return *actor_id;
+}
+
+int actor_node(actor_id_t actor) {
+    actor_t *target = actor_system_actor(actor_system_self(), actor);
+
+    return target == NULL ? -1 : (int) target->node;
+}
+
+int actor_system_node_self() {
+    if (thread_system == NULL) {
+        return -1;
+    }
+
+    worker_t *worker = pthread_getspecific(thread_system->thread_pool->key_worker);
+
+    return worker == NULL ? -1 : (int) worker->node;
+}
+
+void actor_system_config_default(actor_system_config_t *config) {
+    config->workers = POOL_SIZE;
+    config->pin_workers = false;
+    config->thread_name = "cacti";
+    config->stack_size = 0;
+    config->trace_path = getenv("CACTI_TRACE_FILE") != NULL
+                         ? getenv("CACTI_TRACE_FILE") : "cacti-trace.json";
+    config->numa = false;
+    config->numa_topology = getenv("CACTI_NUMA_TOPOLOGY");
+    config->hugepages = false;
+}
+
+int actor_system_create(actor_id_t *actor, role_t *const role) {
+    actor_system_config_t config;
+    actor_system_config_default(&config);
+
+    return actor_system_create_config(actor, role, &config);
+}
+
+int actor_system_launch(actor_system_t *system, actor_id_t *actor,
+                        role_t *const role, const actor_system_config_t *config) {
+    if (config->stack_size != 0 && config->stack_size < (size_t) PTHREAD_STACK_MIN) {
+        return -1;
+    }
+
+    int err;
+    if ((err = actor_system_init(system, config))) {
+        return err;
+    }
+    else {
+        *actor = actor_system_spawn_actor(system, role);
+        if (*actor < 0) {
+            return -1;
+        }
+        else {
+            if ((err = actor_send_hello_message(system, *actor, 0, NULL))) {
+                fprintf(stderr, "%s: failed to send hello\n", __func__);
+            }
+
+            return err;
+        }
+    }
+}
+
+int actor_system_create_config(actor_id_t *actor, role_t *const role,
+                               const actor_system_config_t *config) {
+    if (default_system.created) {
+        return -1;
+    }
+
+    return actor_system_launch(&default_system, actor, role, config);
+}
+
+int actor_system_start(actor_system_t **system, actor_id_t *actor,
+                       role_t *const role, const actor_system_config_t *config) {
+    *system = calloc(1, sizeof(actor_system_t));
+    check_for_successful_alloc(*system);
+
+    int err = actor_system_launch(*system, actor, role, config);
+    if (err && !(*system)->created) {
+        free(*system);
+        *system = NULL;
+    }
+
+    return err;
+}
+
+bool actor_system_finish(actor_system_t *system, actor_id_t actor) {
+    if (!system->created) {
+        return false;
+    }
+    else if (!actor_system_legal_actor_id(system, actor)) {
+        fprintf(stderr, "%s: invalid actor id\n", __func__);
+
+        return false;
+    }
+
+    thread_pool_join(system->thread_pool);
+    actor_system_dispose(system);
+
+    return true;
+}
+
+void actor_system_join(actor_id_t actor) {
+    actor_system_finish(&default_system, actor);
+}
+
+void actor_system_wait(actor_system_t *system, actor_id_t actor) {
+    if (actor_system_finish(system, actor) && system != &default_system) {
+        free(system);
+    }
+}
+
+/* Publishes a message for which a place has been reserved in its lane. */
+void actor_deliver_message(actor_t *actor, const message_t *message,
+                           timer_id_t timer) {
+    TRACE(actor->system, TRACE_SEND, actor->actor_id, message->message_type);
+    mailbox_push(actor_lane(actor, message), message, timer);
+    if (!atomic_exchange(&actor->scheduled, true)) {
+        actor_schedule_for_execution(actor);
+    }
+}
+
+int message_inline(message_t *message, message_type_t message_type,
+                   const void *data, size_t nbytes) {
+    if (nbytes > MESSAGE_INLINE_BYTES) {
+        return -1;
+    }
+
+    message->message_type = message_type;
+    message->nbytes = nbytes;
+    message->data = NULL;
+    message->release = NULL;
+    message->flags = MSG_FLAG_INLINE;
+    memcpy(message->payload, data, nbytes);
+
+    return 0;
+}
+
+int actor_system_send(actor_system_t *system, actor_id_t actor, message_t message) {
+    actor_t *target = actor_system_actor(system, actor);
+    if (target == NULL) {
+        message_release(&message);
+
+        return -2;
+    }
+    else {
+        int err;
+        if ((err = actor_reserve_message(target, actor_lane(target, &message),
+                                         actor_generation(actor)))) {
+            message_release(&message);
+
+            return err;
+        }
+
+        actor_deliver_message(target, &message, -1);
+
+        return 0;
+    }
+}
+
+int send_message(actor_id_t actor, message_t message) {
+    return actor_system_send(actor_system_self(), actor, message);
+}
+
+/* The hello of an actor spawned directly carries a copy of its init data,
+ * inline if it fits. */
+message_t actor_hello_message(size_t init_nbytes, const void *init_data) {
+    message_t hello = {
+            .message_type = MSG_HELLO,
+            .nbytes = 0,
+            .data = NULL
+    };
+
+    if (init_nbytes > 0
+        && message_inline(&hello, MSG_HELLO, init_data, init_nbytes) != 0) {
+        hello.nbytes = init_nbytes;
+        hello.data = message_payload_alloc(init_nbytes);
+        hello.release = message_payload_release;
+        memcpy(hello.data, init_data, init_nbytes);
+    }
+
+    return hello;
+}
+
+/* A new actor has room for its hello, unless it has been closed since. */
+bool actor_greet(actor_t *actor, message_t *hello) {
+    if (actor_try_reserve_message(&actor->urgent, actor_generation(actor->actor_id),
+                                  actor->urgent.limit)) {
+        message_release(hello);
+
+        return false;
+    }
+
+    TRACE(actor->system, TRACE_SEND, actor->actor_id, MSG_HELLO);
+    mailbox_push(&actor->urgent, hello, -1);
+
+    return true;
+}
+
+actor_id_t actor_system_spawn(actor_system_t *system, role_t *role,
+                              size_t init_nbytes, const void *init_data) {
+    actor_t *actor;
+    if (!system->created || actor_system_spawn_actors(system, role, &actor, 1) == 0) {
+        return -1;
+    }
+
+    actor_id_t actor_id = actor->actor_id;
+    message_t hello = actor_hello_message(init_nbytes, init_data);
+    if (!actor_greet(actor, &hello)) {
+        return -1;
+    }
+    if (!atomic_exchange(&actor->scheduled, true)) {
+        actor_schedule_for_execution(actor);
+    }
+
+    return actor_id;
+}
+
+actor_id_t actor_spawn(role_t *role, size_t init_nbytes, const void *init_data) {
+    return actor_system_spawn(actor_system_self(), role, init_nbytes, init_data);
+}
+
+/* The actors are taken from the table under a single lock, and scheduled
+ * in batches. Their ids are read before, as they may die and be reused as
+ * soon as they are scheduled. */
+size_t actor_system_spawn_many(actor_system_t *system, role_t *role, size_t n,
+                               actor_id_t *actors, size_t init_nbytes,
+                               const void *init_data) {
+    if (!system->created || n == 0) {
+        return 0;
+    }
+
+    actor_t **spawned = malloc(n * sizeof(actor_t *));
+    check_for_successful_alloc(spawned);
+    n = actor_system_spawn_actors(system, role, spawned, n);
+
+    actor_t *scheduled[BROADCAST_BATCH];
+    size_t nscheduled = 0;
+    size_t nbytes = init_data == NULL ? 0 : init_nbytes;
+    size_t greeted = 0;
+    for (size_t i = 0; i < n; i++) {
+        actor_id_t actor_id = spawned[i]->actor_id;
+        const char *data = nbytes == 0 ? NULL : (const char *) init_data + i * nbytes;
+        message_t hello = actor_hello_message(nbytes, data);
+        if (!actor_greet(spawned[i], &hello)) {
+            continue;
+        }
+
+        actors[greeted++] = actor_id;
+        if (!atomic_exchange(&spawned[i]->scheduled, true)) {
+            scheduled[nscheduled++] = spawned[i];
+            if (nscheduled == BROADCAST_BATCH) {
+                actor_schedule_many(system, scheduled, nscheduled);
+                nscheduled = 0;
+            }
+        }
+    }
+    actor_schedule_many(system, scheduled, nscheduled);
+
+    free(spawned);
+
+    return greeted;
+}
+
+size_t actor_spawn_many(role_t *role, size_t n, actor_id_t *actors,
+                        size_t init_nbytes, const void *init_data) {
+    return actor_system_spawn_many(actor_system_self(), role, n, actors,
+                                   init_nbytes, init_data);
+}
+
+void messages_release(const message_t *messages, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        message_t message = messages[i];
+        message_release(&message);
+    }
+}
+
+int actor_system_send_messages(actor_system_t *system, actor_id_t actor,
+                               const message_t *messages, size_t n) {
+    actor_t *target = actor_system_actor(system, actor);
+    if (target == NULL) {
+        messages_release(messages, n);
+
+        return -2;
+    }
+    else if (n == 0) {
+        return 0;
+    }
+    else {
+        /* Only the leading messages sharing the lane of the first go now. */
+        mailbox_t *mailbox = actor_lane(target, &messages[0]);
+        size_t same_lane = 1;
+        while (same_lane < n && actor_lane(target, &messages[same_lane]) == mailbox) {
+            same_lane++;
+        }
+
+        int reserved = actor_reserve_messages(target, mailbox,
+                                              actor_generation(actor), same_lane);
+        if (reserved < 0) {
+            messages_release(messages, n);
+
+            return reserved;
+        }
+
+        for (int i = 0; CACTI_TRACE && i < reserved; i++) {
+            TRACE(system, TRACE_SEND, actor, messages[i].message_type);
+        }
+        mailbox_push_many(mailbox, messages, reserved);
+        if (!atomic_exchange(&target->scheduled, true)) {
+            actor_schedule_for_execution(target);
+        }
+
+        return reserved;
+    }
+}
+
+int send_messages(actor_id_t actor, const message_t *messages, size_t n) {
+    return actor_system_send_messages(actor_system_self(), actor, messages, n);
+}
+
+group_id_t actor_system_group(actor_system_t *system, const char *name) {
+    if (!system->created || name == NULL) {
+        return -1;
+    }
+
+    mutex_lock(&system->groups_mutex);
+
+    group_id_t group_id = 0;
+    while ((size_t) group_id < system->ngroups
+           && strcmp(system->groups[group_id]->name, name) != 0) {
+        group_id++;
+    }
+
+    if ((size_t) group_id == system->ngroups) {
+        if (system->ngroups == system->groups_capacity) {
+            system->groups_capacity = system->groups_capacity == 0
+                                           ? 1 : system->groups_capacity * 2;
+            system->groups = realloc(
+                    system->groups,
+                    system->groups_capacity * sizeof(group_t *));
+            check_for_successful_alloc(system->groups);
+        }
+
+        system->groups[system->ngroups++] = group_create(name);
+    }
+
+    mutex_unlock(&system->groups_mutex);
+
+    return group_id;
+}
+
+group_id_t actor_group(const char *name) {
+    return actor_system_group(actor_system_self(), name);
+}
+
+int actor_system_group_join(actor_system_t *system, group_id_t group_id,
+                            actor_id_t actor) {
+    group_t *group = actor_system_find_group(system, group_id);
+    if (group == NULL || !actor_system_legal_actor_id(system, actor)) {
+        return -2;
+    }
+
+    mutex_lock(&group->mutex);
+
+    size_t i = 0;
+    while (i < group->nmembers && group->members[i] != actor) {
+        i++;
+    }
+
+    if (i == group->nmembers) {
+        if (group->nmembers == group->capacity) {
+            group->capacity = group->capacity == 0 ? 16 : group->capacity * 2;
+            group->members = realloc(group->members,
+                                     group->capacity * sizeof(actor_id_t));
+            check_for_successful_alloc(group->members);
+        }
+
+        group->members[group->nmembers++] = actor;
+    }
+
+    mutex_unlock(&group->mutex);
+
+    return 0;
+}
+
+int actor_group_join(group_id_t group_id, actor_id_t actor) {
+    return actor_system_group_join(actor_system_self(), group_id, actor);
+}
+
+int actor_system_group_leave(actor_system_t *system, group_id_t group_id,
+                             actor_id_t actor) {
+    group_t *group = actor_system_find_group(system, group_id);
+    if (group == NULL) {
+        return -2;
+    }
+
+    mutex_lock(&group->mutex);
+
+    int err = -1;
+    for (size_t i = 0; i < group->nmembers; i++) {
+        if (group->members[i] == actor) {
+            group->members[i] = group->members[--group->nmembers];
+            err = 0;
+            break;
+        }
+    }
+
+    mutex_unlock(&group->mutex);
+
+    return err;
+}
+
+int actor_group_leave(group_id_t group_id, actor_id_t actor) {
+    return actor_system_group_leave(actor_system_self(), group_id, actor);
+}
+
+/* Members are scheduled in batches of BROADCAST_BATCH, so a broadcast takes
+ * the injection queue lock and wakes sleeping workers once per batch. */
+int actor_system_broadcast(actor_system_t *system, group_id_t group_id,
+                           message_t message) {
+    group_t *group = actor_system_find_group(system, group_id);
+    if (group == NULL) {
+        message_release(&message);
+
+        return -2;
+    }
+    else if (message.release != NULL && message.release != message_payload_release) {
+        message_release(&message);
+
+        return -1;
+    }
+
+    actor_t *scheduled[BROADCAST_BATCH];
+    size_t nscheduled = 0;
+    int delivered = 0;
+
+    mutex_lock(&group->mutex);
+
+    size_t i = 0;
+    while (i < group->nmembers) {
+        actor_id_t member = group->members[i];
+        actor_t *target = actor_system_actor(system, member);
+        mailbox_t *mailbox = target == NULL ? NULL : actor_lane(target, &message);
+        int err = target == NULL ? -1 : actor_try_reserve_message(
+                mailbox, actor_generation(member), mailbox->limit);
+
+        if (err == -1) {
+            group->members[i] = group->members[--group->nmembers];
+            continue;
+        }
+
+        i++;
+        if (err) {
+            continue;
+        }
+
+        if (message.release != NULL) {
+            message_payload_retain(message.data);
+        }
+        TRACE(system, TRACE_SEND, member, message.message_type);
+        mailbox_push(mailbox, &message, -1);
+        delivered++;
+
+        if (!atomic_exchange(&target->scheduled, true)) {
+            scheduled[nscheduled++] = target;
+            if (nscheduled == BROADCAST_BATCH) {
+                actor_schedule_many(system, scheduled, nscheduled);
+                nscheduled = 0;
+            }
+        }
+    }
+
+    mutex_unlock(&group->mutex);
+
+    actor_schedule_many(system, scheduled, nscheduled);
+    message_release(&message);
+
+    return delivered;
+}
+
+int broadcast_message(group_id_t group_id, message_t message) {
+    return actor_system_broadcast(actor_system_self(), group_id, message);
+}
+
+timer_id_t actor_system_send_after(actor_system_t *system, actor_id_t actor,
+                                   message_t message, unsigned long delay_msec) {
+    if (actor_system_actor(system, actor) == NULL) {
+        message_release(&message);
+
+        return -2;
+    }
+
+    return timer_wheel_arm(&system->timer_wheel, actor, message,
+                           delay_msec * (1000000L / TIMER_TICK_NSEC), 0);
+}
+
+timer_id_t send_message_after(actor_id_t actor, message_t message,
+                              unsigned long delay_msec) {
+    return actor_system_send_after(actor_system_self(), actor, message, delay_msec);
+}
+
+timer_id_t actor_system_send_every(actor_system_t *system, actor_id_t actor,
+                                   message_t message, unsigned long period_msec) {
+    if (actor_system_actor(system, actor) == NULL) {
+        message_release(&message);
+
+        return -2;
+    }
+    else if (period_msec == 0
+             || (message.release != NULL
+                 && message.release != message_payload_release)) {
+        message_release(&message);
+
+        return -1;
+    }
+
+    uint64_t period = period_msec * (1000000L / TIMER_TICK_NSEC);
+    return timer_wheel_arm(&system->timer_wheel, actor, message, period, period);
+}
+
+timer_id_t send_message_every(actor_id_t actor, message_t message,
+                              unsigned long period_msec) {
+    return actor_system_send_every(actor_system_self(), actor, message, period_msec);
+}
+
+int actor_system_cancel_timer(actor_system_t *system, timer_id_t timer_id) {
+    timer_wheel_t *timer_wheel = &system->timer_wheel;
+
+    mutex_lock(&timer_wheel->mutex);
+
+    timer_entry_t *timer = timer_wheel_timer(timer_wheel, timer_id);
+    if (timer != NULL) {
+        timer_wheel_unlink(timer);
+        message_release(&timer->message);
+        timer_wheel_disarm(timer_wheel, timer);
+    }
+
+    mutex_unlock(&timer_wheel->mutex);
+
+    return timer == NULL ? -1 : 0;
+}
+
+int cancel_timer(timer_id_t timer_id) {
+    return actor_system_cancel_timer(actor_system_self(), timer_id);
+}
+
+int actor_system_try_send(actor_system_t *system, actor_id_t actor,
+                          message_t message) {
+    actor_t *target = actor_system_actor(system, actor);
+    if (target == NULL) {
+        message_release(&message);
+
+        return -2;
+    }
+    else {
+        mailbox_t *mailbox = actor_lane(target, &message);
+        int err;
+        if ((err = actor_try_reserve_message(mailbox, actor_generation(actor),
+                                             mailbox->limit))) {
+            if (err != -3) {
+                message_release(&message);
+            }
+
+            return err;
+        }
+
+        actor_deliver_message(target, &message, -1);
+
+        return 0;
+    }
+}
+
+int try_send_message(actor_id_t actor, message_t message) {
+    return actor_system_try_send(actor_system_self(), actor, message);
+}
+
+int actor_system_send_async(actor_system_t *system, actor_id_t actor,
+                            message_t message, message_type_t notify_type) {
+    actor_t *target = actor_system_actor(system, actor);
+    actor_system_t *self_system = thread_system;
+    actor_id_t *self = self_system == NULL ? NULL : pthread_getspecific(
+            self_system->thread_pool->key_actor_id);
+    if (target == NULL) {
+        message_release(&message);
+
+        return -2;
+    }
+    else {
+        mailbox_t *mailbox = actor_lane(target, &message);
+        uint64_t generation = actor_generation(actor);
+        int err;
+        while ((err = actor_try_reserve_message(mailbox, generation,
+                                                mailbox->limit)) == -3) {
+            if (self == NULL
+                || actor_wait_for_space(target, mailbox, generation, self_system,
+                                        *self, notify_type)) {
+                return -3;
+            }
+        }
+
+        if (err) {
+            message_release(&message);
+
+            return err;
+        }
+
+        actor_deliver_message(target, &message, -1);
+
+        return 0;
+    }
+}
+
+int send_message_async(actor_id_t actor, message_t message,
+                       message_type_t notify_type) {
+    return actor_system_send_async(actor_system_self(), actor, message, notify_type);
+}
+
+unsigned long long stats_histogram_percentile(const stats_histogram_t *histogram,
+                                              double fraction) {
+    unsigned long long seen = 0;
+    for (size_t i = 0; i < STATS_BUCKETS; i++) {
+        seen += histogram->buckets[i];
+        if (seen > 0 && (double) seen >= fraction * (double) histogram->count) {
+            unsigned long long bound = i == 0 ? 0 : (1ull << i) - 1;
+
+            return bound < histogram->max ? bound : histogram->max;
+        }
+    }
+
+    return histogram->max;
+}
+
+int actor_system_stats_of(actor_system_t *system, actor_system_stats_t *stats) {
+    if (!system->created) {
+        return -1;
+    }
+
+    thread_pool_t *thread_pool = system->thread_pool;
+    blocking_executor_t *blocking_executor = &system->blocking_executor;
+
+    memset(stats, 0, sizeof(actor_system_stats_t));
+    stats->nworkers = thread_pool->nworkers;
+    stats->workers = calloc(stats->nworkers, sizeof(thread_stats_summary_t));
+    check_for_successful_alloc(stats->workers);
+
+    for (size_t i = 0; i < stats->nworkers; i++) {
+        thread_stats_export(&stats->workers[i], &thread_pool->workers[i].stats);
+        thread_summary_add(&stats->total, &stats->workers[i]);
+    }
+
+    mutex_lock(&blocking_executor->mutex);
+
+    thread_stats_export(&stats->blocking, &blocking_executor->retired_stats);
+    for (thread_stats_t *blocking_stats = blocking_executor->thread_stats;
+         blocking_stats != NULL; blocking_stats = blocking_stats->next) {
+        thread_stats_summary_t summary;
+        memset(&summary, 0, sizeof(thread_stats_summary_t));
+        thread_stats_export(&summary, blocking_stats);
+        thread_summary_add(&stats->blocking, &summary);
+    }
+
+    mutex_unlock(&blocking_executor->mutex);
+
+    thread_summary_add(&stats->total, &stats->blocking);
+
+    return 0;
+}
+
+int actor_system_stats(actor_system_stats_t *stats) {
+    return actor_system_stats_of(actor_system_self(), stats);
+}
+
+void actor_system_stats_free(actor_system_stats_t *stats) {
+    free(stats->workers);
+    stats->workers = NULL;
+    stats->nworkers = 0;
+}
+
+int actor_system_handler_stats_of(actor_system_t *system, const role_t *role,
+                                  message_type_t message_type,
+                                  stats_histogram_t *histogram) {
+    if (!system->created) {
+        return -1;
+    }
+
+    thread_pool_t *thread_pool = system->thread_pool;
+    blocking_executor_t *blocking_executor = &system->blocking_executor;
+
+    memset(histogram, 0, sizeof(stats_histogram_t));
+    for (size_t i = 0; i < thread_pool->nworkers; i++) {
+        thread_stats_export_handler(histogram, &thread_pool->workers[i].stats,
+                                    role, message_type);
+    }
+
+    mutex_lock(&blocking_executor->mutex);
+
+    thread_stats_export_handler(histogram, &blocking_executor->retired_stats,
+                                role, message_type);
+    for (thread_stats_t *blocking_stats = blocking_executor->thread_stats;
+         blocking_stats != NULL; blocking_stats = blocking_stats->next) {
+        thread_stats_export_handler(histogram, blocking_stats, role, message_type);
+    }
+
+    mutex_unlock(&blocking_executor->mutex);
+
+    return 0;
+}
+
+int actor_system_handler_stats(const role_t *role, message_type_t message_type,
+                               stats_histogram_t *histogram) {
+    return actor_system_handler_stats_of(actor_system_self(), role, message_type,
+                                         histogram);
+}
@@ -2,6 +2,8 @@
 #define CACTI_H
 
 #include <stddef.h>
+#include <stdbool.h>
+#include <stdalign.h>
 
 typedef long message_type_t;
 
@@ -17,31 +19,323 @@ typedef long message_type_t;
 #define CAST_LIMIT 1048576
 #endif
 
+/* Capacity of the lane for urgent messages, separate from the mailbox. */
+#ifndef ACTOR_URGENT_LIMIT
+#define ACTOR_URGENT_LIMIT ACTOR_QUEUE_LIMIT
+#endif
+
+/* Default number of workers, 0 stands for one worker per online CPU. */
 #ifndef POOL_SIZE
-#define POOL_SIZE 3
+#define POOL_SIZE 0
+#endif
+
+#ifndef MESSAGE_INLINE_BYTES
+#define MESSAGE_INLINE_BYTES 48
+#endif
+
+#ifndef BLOCKING_POOL_LIMIT
+#define BLOCKING_POOL_LIMIT 64
+#endif
+
+#ifndef ACTOR_ACTIVATION_MESSAGES
+#define ACTOR_ACTIVATION_MESSAGES 64
+#endif
+
+#ifndef ACTOR_ACTIVATION_NSEC
+#define ACTOR_ACTIVATION_NSEC 200000
+#endif
+
+/* Runtime statistics, see actor_system_stats. 0 compiles them out. */
+#ifndef CACTI_STATS
+#define CACTI_STATS 1
 #endif
 
+#define STATS_BUCKETS 40
+
+/* Tracing of spawns, sends, scheduling, dispatches and deaths into
+ * per-thread rings of CACTI_TRACE_EVENTS events, written out in the Chrome
+ * trace format when the actor system is joined. 0 compiles it out. */
+#ifndef CACTI_TRACE
+#define CACTI_TRACE 0
+#endif
+
+#ifndef CACTI_TRACE_EVENTS
+#define CACTI_TRACE_EVENTS 65536
+#endif
+
+/* The payload of the message is stored in the message itself, and the
+ * handler gets a pointer to a copy of it instead of data. */
+#define MSG_FLAG_INLINE 0x1u
+
+/* The handler of the message may block, so it runs on a thread of the
+ * blocking executor instead of a worker. */
+#define MSG_FLAG_BLOCKING 0x2u
+
+/* The message skips the backlog of the actor: it goes to a lane that is
+ * drained before the mailbox, as MSG_HELLO, MSG_SPAWN and MSG_GODIE do. */
+#define MSG_FLAG_URGENT 0x4u
+
+typedef void (*release_t)(void *data);
+
+/* A message with a release function owns data. The runtime calls it after
+ * the handler returns, or when the message is refused with -1 or -2 or left
+ * undelivered at shutdown. A message refused for lack of room (-3) stays
+ * with the sender. */
 typedef struct message {
     message_type_t message_type;
     size_t nbytes;
     void *data;
+    release_t release;
+    unsigned int flags;
+    alignas(max_align_t) unsigned char payload[MESSAGE_INLINE_BYTES];
 } message_t;
 
+/* Copies nbytes of data into the payload of the message. Fails if they do
+ * not fit in MESSAGE_INLINE_BYTES. */
+int message_inline(message_t *message, message_type_t message_type,
+                   const void *data, size_t nbytes);
+
+/* Payloads with a reference count, served from per-size slabs. A new
+ * payload holds one reference; message_payload_release is meant to be used
+ * as the release function of the messages carrying it. */
+void *message_payload_alloc(size_t nbytes);
+
+void message_payload_retain(void *data);
+
+void message_payload_release(void *data);
+
 typedef long actor_id_t;
 
 actor_id_t actor_id_self();
 
+/* The home NUMA node of the actor, or -1 if there is no such actor. */
+int actor_node(actor_id_t actor);
+
+/* The NUMA node of the worker calling it, or -1 for other threads. */
+int actor_system_node_self();
+
 typedef void (*const act_t)(void **stateptr, size_t nbytes, void *data);
 
+/* All handlers of the role may block, as if every message it gets had
+ * MSG_FLAG_BLOCKING set. */
+#define ROLE_FLAG_BLOCKING 0x1u
+
+/* Messages whose type has a NULL prompt are dropped, like those of a type
+ * past nprompts. */
 typedef struct role {
     size_t nprompts;
     act_t *prompts;
+    unsigned int flags;
 } role_t;
 
+/* workers equal to 0 stands for one worker per online CPU. Pinned workers
+ * are bound round-robin to the CPUs the process may run on. Worker threads
+ * are named thread_name followed by their index, unless thread_name is NULL.
+ * stack_size equal to 0 keeps the default stack size of threads running
+ * actors. With CACTI_TRACE, the trace is written to trace_path.
+ *
+ * With numa set, which it is not by default, and more than one NUMA node,
+ * workers are split between the nodes and kept on their CPUs even if they
+ * are not pinned, and every actor gets a home node, whose memory holds it
+ * and its mailboxes and whose workers it prefers to run on. numa_topology
+ * simulates a topology instead of the one of the machine: the CPU lists of
+ * the nodes, separated by semicolons, like "0-3;4-7". The memory of the
+ * nodes comes from huge pages if hugepages is set and the system has them. */
+typedef struct actor_system_config {
+    size_t workers;
+    bool pin_workers;
+    const char *thread_name;
+    size_t stack_size;
+    const char *trace_path;
+    bool numa;
+    const char *numa_topology;
+    bool hugepages;
+} actor_system_config_t;
+
+void actor_system_config_default(actor_system_config_t *config);
+
 int actor_system_create(actor_id_t *actor, role_t *const role);
 
+int actor_system_create_config(actor_id_t *actor, role_t *const role,
+                               const actor_system_config_t *config);
+
 void actor_system_join(actor_id_t actor);
 
+/* An actor system started with actor_system_start runs independently of
+ * the default one, which actor_system_create and actor_system_join manage,
+ * with its own workers, actors, timers and groups. Actor ids only name
+ * actors within their system. */
+typedef struct actor_system actor_system_t;
+
+/* The system of the calling thread if it is one of the threads of a
+ * system, and the default one otherwise. Functions not given a system act
+ * on this one; each has an actor_system_ variant taking the system, which
+ * may be called from any thread. */
+actor_system_t *actor_system_self();
+
+int actor_system_start(actor_system_t **system, actor_id_t *actor,
+                       role_t *const role, const actor_system_config_t *config);
+
+/* Waits until every actor of the system is dead and frees the system. */
+void actor_system_wait(actor_system_t *system, actor_id_t actor);
+
+int actor_system_send(actor_system_t *system, actor_id_t actor, message_t message);
+
+/* Durations in nanoseconds. Bucket 0 counts zeros, bucket i > 0 counts
+ * durations in [2^(i-1), 2^i), and the last bucket all longer ones. */
+typedef struct stats_histogram {
+    unsigned long long count;
+    unsigned long long sum;
+    unsigned long long max;
+    unsigned long long buckets[STATS_BUCKETS];
+} stats_histogram_t;
+
+/* Upper bound of the bucket holding the given fraction of durations. */
+unsigned long long stats_histogram_percentile(const stats_histogram_t *histogram,
+                                              double fraction);
+
+/* queue_wait runs from a message entering a mailbox to its handler being
+ * called, for a sample of the messages, schedule_wait from scheduling an
+ * actor to a worker starting to run it, handler_time over every handled
+ * message, and busy_nsec over whole activations. mailbox_high_water is the
+ * deepest mailbox seen. */
+typedef struct thread_stats_summary {
+    unsigned long long activations;
+    unsigned long long messages;
+    unsigned long long busy_nsec;
+    unsigned long long steals;
+    unsigned long long stolen;
+    unsigned long long parks;
+    unsigned long long mailbox_high_water;
+    stats_histogram_t queue_wait;
+    stats_histogram_t schedule_wait;
+    stats_histogram_t handler_time;
+} thread_stats_summary_t;
+
+/* workers holds nworkers entries, blocking covers the threads of the
+ * blocking executor, and total all of them. */
+typedef struct actor_system_stats {
+    size_t nworkers;
+    thread_stats_summary_t *workers;
+    thread_stats_summary_t blocking;
+    thread_stats_summary_t total;
+} actor_system_stats_t;
+
+/* Aggregates the counters the threads keep, which they keep updating
+ * meanwhile. Fails with -1 when there is no actor system. The result is
+ * freed with actor_system_stats_free. */
+int actor_system_stats(actor_system_stats_t *stats);
+
+int actor_system_stats_of(actor_system_t *system, actor_system_stats_t *stats);
+
+void actor_system_stats_free(actor_system_stats_t *stats);
+
+/* Time spent handling messages of the given type by actors of the role. */
+int actor_system_handler_stats(const role_t *role, message_type_t message_type,
+                               stats_histogram_t *histogram);
+
+int actor_system_handler_stats_of(actor_system_t *system, const role_t *role,
+                                  message_type_t message_type,
+                                  stats_histogram_t *histogram);
+
+/* Spawns an actor of the role in the system of the calling thread at once,
+ * without a MSG_SPAWN round trip. Its hello handler gets a copy of the
+ * init_nbytes of init_data instead of the id of a parent. Returns the id of
+ * the actor, or -1 if no actor can be spawned or there is no actor system. */
+actor_id_t actor_spawn(role_t *role, size_t init_nbytes, const void *init_data);
+
+actor_id_t actor_system_spawn(actor_system_t *system, role_t *role,
+                              size_t init_nbytes, const void *init_data);
+
+/* Spawns up to n actors of the role, taking their entries of the actor
+ * table at once, and stores their ids in actors. The i-th gets the i-th
+ * block of init_nbytes of init_data, unless it is NULL. Returns how many
+ * were spawned. */
+size_t actor_spawn_many(role_t *role, size_t n, actor_id_t *actors,
+                        size_t init_nbytes, const void *init_data);
+
+size_t actor_system_spawn_many(actor_system_t *system, role_t *role, size_t n,
+                               actor_id_t *actors, size_t init_nbytes,
+                               const void *init_data);
+
 int send_message(actor_id_t actor, message_t message);
 
+/* Sends the first of n messages that fit into the mailbox of the actor at
+ * once, blocking only until one fits, and returns how many were sent. Only
+ * messages going to the same lane as the first one are sent together. */
+int send_messages(actor_id_t actor, const message_t *messages, size_t n);
+
+int actor_system_send_messages(actor_system_t *system, actor_id_t actor,
+                               const message_t *messages, size_t n);
+
+/* Returns -3 instead of blocking when the mailbox of the actor is full. */
+int try_send_message(actor_id_t actor, message_t message);
+
+int actor_system_try_send(actor_system_t *system, actor_id_t actor,
+                          message_t message);
+
+/* Like try_send_message, but an actor that gets -3 is later sent a message
+ * of notify_type, with the id of the full actor as data, once there is room
+ * or the actor is dead. */
+int send_message_async(actor_id_t actor, message_t message,
+                       message_type_t notify_type);
+
+int actor_system_send_async(actor_system_t *system, actor_id_t actor,
+                            message_t message, message_type_t notify_type);
+
+typedef long timer_id_t;
+
+/* Delivers the message after delay_msec milliseconds. Timers are serviced
+ * by a runtime thread, so waiting costs no worker time. */
+timer_id_t send_message_after(actor_id_t actor, message_t message,
+                              unsigned long delay_msec);
+
+timer_id_t actor_system_send_after(actor_system_t *system, actor_id_t actor,
+                                   message_t message, unsigned long delay_msec);
+
+/* Delivers the message every period_msec milliseconds until the timer is
+ * cancelled or the actor dies. Periods that end before the previous message
+ * has been handled are skipped, so that at most one is pending at a time.
+ * A message with a release function has to carry a payload from
+ * message_payload_alloc, which gets a reference for every delivery. */
+timer_id_t send_message_every(actor_id_t actor, message_t message,
+                              unsigned long period_msec);
+
+timer_id_t actor_system_send_every(actor_system_t *system, actor_id_t actor,
+                                   message_t message, unsigned long period_msec);
+
+/* Fails if the timer has already fired or been cancelled; otherwise the
+ * message is released. */
+int cancel_timer(timer_id_t timer);
+
+int actor_system_cancel_timer(actor_system_t *system, timer_id_t timer);
+
+typedef long group_id_t;
+
+/* Returns the id of the group with the given name, creating it if needed. */
+group_id_t actor_group(const char *name);
+
+group_id_t actor_system_group(actor_system_t *system, const char *name);
+
+int actor_group_join(group_id_t group, actor_id_t actor);
+
+int actor_system_group_join(actor_system_t *system, group_id_t group,
+                            actor_id_t actor);
+
+int actor_group_leave(group_id_t group, actor_id_t actor);
+
+int actor_system_group_leave(actor_system_t *system, group_id_t group,
+                             actor_id_t actor);
+
+/* Sends the message, with the same data pointer, to every member of the
+ * group that has room in its mailbox, and returns how many received it.
+ * Dead members are removed from the group. A message with a release
+ * function has to carry a payload from message_payload_alloc, which gets a
+ * reference for every member reached, and the reference of the sender is
+ * always released. */
+int broadcast_message(group_id_t group, message_t message);
+
+int actor_system_broadcast(actor_system_t *system, group_id_t group,
+                           message_t message);
+
 #endif
\ No newline at end of file
@@ -1,6 +1,6 @@
 #include <stdio.h>
+#include <stdbool.h>
 #include <stdlib.h>
-#include <unistd.h>
 #include <errno.h>
 #include <string.h>
 
@@ -10,20 +10,20 @@
 #define MESSAGES_TYPES 5
 #endif
 
-#ifndef MSG_INIT_REQUEST
-#define MSG_INIT_REQUEST 1
-#endif
-
 #ifndef MSG_INIT
-#define MSG_INIT 2
+#define MSG_INIT 1
 #endif
 
 #ifndef MSG_COMPUTE
-#define MSG_COMPUTE 3
+#define MSG_COMPUTE 2
 #endif
 
 #ifndef MSG_FINISH
-#define MSG_FINISH 4
+#define MSG_FINISH 3
+#endif
+
+#ifndef MSG_CELL_DONE
+#define MSG_CELL_DONE 4
 #endif
 
 #define UNUSED(x) (void)(x)
@@ -38,147 +38,178 @@ typedef struct pair {
 typedef struct init_data {
     size_t col;
     int val;
+    actor_id_t parent;
     role_t *role_for_children;
 } init_data_t;
 
+typedef struct partial_sum {
+    size_t row;
+    long sum;
+} partial_sum_t;
+
+/* Rows wait in pending while the cell of the first one is being computed,
+ * so that they leave the actor in the order they came. */
 typedef struct matrix_comp {
     size_t col;
     int val;
     actor_id_t id_self;
     actor_id_t parent;
     role_t *role_for_children;
-    init_data_t on_init_request_data;
+    partial_sum_t *pending;
+    size_t pending_first;
+    size_t pending_count;
+    bool finishing;
 } matrix_comp_t;
 
 pair_t **matrix;
 
-typedef struct partial_sum {
-    size_t row;
-    long sum;
-} partial_sum_t;
-
-partial_sum_t *partial_sum;
-
-void on_hello(void **stateptr, size_t nbytes, void *data) {
-    UNUSED(nbytes);
+matrix_comp_t *matrix_comp_create() {
+    matrix_comp_t *matrix_comp = malloc(sizeof(matrix_comp_t));
+    if (matrix_comp == NULL) {
+        exit(EXIT_FAILURE);
+    }
 
-    *stateptr = malloc(sizeof(matrix_comp_t));
-    if (*stateptr == NULL) {
+    matrix_comp->pending = malloc(k * sizeof(partial_sum_t));
+    if (matrix_comp->pending == NULL) {
         exit(EXIT_FAILURE);
     }
+    matrix_comp->pending_first = 0;
+    matrix_comp->pending_count = 0;
+    matrix_comp->finishing = false;
 
-    matrix_comp_t *matrix_comp = *stateptr;
-    matrix_comp->id_self = actor_id_self();
-    matrix_comp->parent = (actor_id_t) data;
+    return matrix_comp;
+}
 
-    message_t init_request = {
-            .message_type = MSG_INIT_REQUEST,
-            .nbytes = sizeof(actor_id_t),
-            .data = &matrix_comp->id_self
-    };
+void send_inline(actor_id_t actor, message_type_t message_type,
+                 const void *data, size_t nbytes) {
+    message_t message = {0};
+    message_inline(&message, message_type, data, nbytes);
 
     int err;
-    if ((err = send_message(matrix_comp->parent, init_request))) {
+    if ((err = send_message(actor, message))) {
         fprintf(stderr, "Sending message to an actor failed: %d\n", err);
     }
 }
 
+/* The last column starts computing rows, the others spawn the actor of
+ * the previous column with its part of the computation already in the
+ * hello. */
+void init(matrix_comp_t *matrix_comp, init_data_t *init_data) {
+    matrix_comp->col = init_data->col;
+    matrix_comp->val = init_data->val;
+    matrix_comp->role_for_children = init_data->role_for_children;
+
+    if (matrix_comp->col == 0) {
+        partial_sum_t first_row = {
+                .row = 0,
+                .sum = 0
+        };
+
+        send_inline(actor_id_self(), MSG_COMPUTE, &first_row, sizeof(partial_sum_t));
+    }
+    else {
+        init_data_t child_init_data = {
+                .col = matrix_comp->col - 1,
+                .val = 0,
+                .parent = matrix_comp->id_self,
+                .role_for_children = matrix_comp->role_for_children
+        };
+
+        if (actor_spawn(matrix_comp->role_for_children,
+                        sizeof(init_data_t), &child_init_data) < 0) {
+            fprintf(stderr, "Spawning an actor failed\n");
+        }
+    }
+}
+
+void on_hello(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(nbytes);
+
+    init_data_t *init_data = data;
+
+    *stateptr = matrix_comp_create();
+
+    matrix_comp_t *matrix_comp = *stateptr;
+    matrix_comp->id_self = actor_id_self();
+    matrix_comp->parent = init_data->parent;
+
+    init(matrix_comp, init_data);
+}
+
 void on_hello_first_actor(void **stateptr, size_t nbytes, void *data) {
     UNUSED(nbytes);
     UNUSED(data);
 
-    *stateptr = malloc(sizeof(matrix_comp_t));
-    if (*stateptr == NULL) {
-        exit(EXIT_FAILURE);
-    }
+    *stateptr = matrix_comp_create();
 
     matrix_comp_t *matrix_comp = *stateptr;
     matrix_comp->id_self = actor_id_self();
 }
 
-void on_init_request(void **stateptr, size_t nbytes, void *data) {
+void on_init(void **stateptr, size_t nbytes, void *data) {
     UNUSED(nbytes);
 
-    actor_id_t *requester = data;
+    init(*stateptr, data);
+}
 
-    matrix_comp_t *matrix_comp = *stateptr;
-    matrix_comp->on_init_request_data.col = matrix_comp->col - 1;
-    matrix_comp->on_init_request_data.val = 0;
-    matrix_comp->on_init_request_data.role_for_children = matrix_comp->role_for_children;
-
-    message_t init = {
-            .message_type = MSG_INIT,
-            .nbytes = sizeof(init_data_t),
-            .data = &matrix_comp->on_init_request_data
+/* The time a cell takes is waited out on a timer, without holding a
+ * worker. */
+void start_cell(matrix_comp_t *matrix_comp) {
+    size_t curr_row = matrix_comp->pending[matrix_comp->pending_first].row;
+    pair_t matrix_cell = matrix[curr_row][matrix_comp->col];
+
+    message_t cell_done = {
+            .message_type = MSG_CELL_DONE,
+            .nbytes = 0,
+            .data = NULL
     };
 
-    int err;
-    if ((err = send_message(*requester, init))) {
-        fprintf(stderr, "Sending message to an actor failed: %d\n", err);
+    timer_id_t timer = send_message_after(matrix_comp->id_self, cell_done,
+                                          matrix_cell.time);
+    if (timer < 0) {
+        fprintf(stderr, "Scheduling message to an actor failed: %ld\n", timer);
     }
 }
 
-void on_init(void **stateptr, size_t nbytes, void *data) {
+void finish(void **stateptr);
+
+void on_compute(void **stateptr, size_t nbytes, void *data) {
     UNUSED(nbytes);
 
-    init_data_t *init_data = data;
     matrix_comp_t *matrix_comp = *stateptr;
-    matrix_comp->col = init_data->col;
-    matrix_comp->val = init_data->val;
-    matrix_comp->role_for_children = init_data->role_for_children;
+    partial_sum_t *partial_comp = data;
 
-    int err;
-    if (matrix_comp->col == 0) {
-        message_t compute = {
-                .message_type = MSG_COMPUTE,
-                .nbytes = sizeof(partial_sum_t),
-                .data = &partial_sum[0]
-        };
+    size_t last = (matrix_comp->pending_first + matrix_comp->pending_count) % k;
+    matrix_comp->pending[last] = *partial_comp;
+    matrix_comp->pending_count++;
 
-        if ((err = send_message(actor_id_self(), compute))) {
-            fprintf(stderr, "Sending message to an actor failed: %d\n", err);
-        }
-    }
-    else {
-        message_t spawn = {
-                .message_type = MSG_SPAWN,
-                .nbytes = sizeof(role_t),
-                .data = matrix_comp->role_for_children
-        };
-
-        if ((err = send_message(actor_id_self(), spawn))) {
-            fprintf(stderr, "Sending message to an actor failed: %d\n", err);
-        }
+    if (matrix_comp->pending_count == 1) {
+        start_cell(matrix_comp);
     }
 }
 
-void on_compute(void **stateptr, size_t nbytes, void *data) {
+void on_cell_done(void **stateptr, size_t nbytes, void *data) {
     UNUSED(nbytes);
+    UNUSED(data);
 
     matrix_comp_t *matrix_comp = *stateptr;
-    partial_sum_t *partial_comp = data;
-    size_t curr_row = partial_comp->row;
-    pair_t matrix_cell = matrix[curr_row][matrix_comp->col];
+    partial_sum_t partial_comp = matrix_comp->pending[matrix_comp->pending_first];
+    matrix_comp->pending_first = (matrix_comp->pending_first + 1) % k;
+    matrix_comp->pending_count--;
 
-    usleep(matrix_cell.time * 1000);
+    size_t curr_row = partial_comp.row;
+    pair_t matrix_cell = matrix[curr_row][matrix_comp->col];
 
     matrix_comp->val = matrix_cell.val;
-    partial_comp->sum += matrix_comp->val;
+    partial_comp.sum += matrix_comp->val;
 
     int err;
     if (matrix_comp->col == n - 1) {
-        printf("%ld\n", partial_comp->sum);
+        printf("%ld\n", partial_comp.sum);
     }
     else {
-        message_t compute = {
-                .message_type = MSG_COMPUTE,
-                .nbytes = sizeof(partial_sum_t),
-                .data = partial_comp
-        };
-
-        if ((err = send_message(matrix_comp->parent, compute))) {
-            fprintf(stderr, "Sending message to an actor failed: %d\n", err);
-        }
+        send_inline(matrix_comp->parent, MSG_COMPUTE,
+                    &partial_comp, sizeof(partial_sum_t));
     }
 
     if (matrix_comp->col == 0) {
@@ -194,23 +225,39 @@ void on_compute(void **stateptr, size_t nbytes, void *data) {
             }
         }
         else {
-            message_t compute = {
-                    .message_type = MSG_COMPUTE,
-                    .nbytes = sizeof(partial_sum_t),
-                    .data = &partial_sum[curr_row + 1]
+            partial_sum_t next_row = {
+                    .row = curr_row + 1,
+                    .sum = 0
             };
 
-            if ((err = send_message(matrix_comp->id_self, compute))) {
-                fprintf(stderr, "Sending message to an actor failed: %d\n", err);
-            }
+            send_inline(matrix_comp->id_self, MSG_COMPUTE,
+                        &next_row, sizeof(partial_sum_t));
         }
     }
+
+    if (matrix_comp->pending_count > 0) {
+        start_cell(matrix_comp);
+    }
+    else if (matrix_comp->finishing) {
+        finish(stateptr);
+    }
 }
 
+/* Rows still pending have to leave the actor before it dies. */
 void on_finish(void **stateptr, size_t nbytes, void *data) {
     UNUSED(nbytes);
     UNUSED(data);
 
+    matrix_comp_t *matrix_comp = *stateptr;
+    if (matrix_comp->pending_count > 0) {
+        matrix_comp->finishing = true;
+    }
+    else {
+        finish(stateptr);
+    }
+}
+
+void finish(void **stateptr) {
     matrix_comp_t *matrix_comp = *stateptr;
 
     int err;
@@ -232,6 +279,7 @@ void on_finish(void **stateptr, size_t nbytes, void *data) {
             .data = NULL
     };
 
+    free(matrix_comp->pending);
     free(matrix_comp);
     *stateptr = NULL;
 
@@ -248,15 +296,7 @@ int main() {
         exit(EXIT_FAILURE);
     }
 
-    partial_sum = malloc(k * sizeof(partial_sum_t));
-    if (partial_sum == NULL) {
-        exit(EXIT_FAILURE);
-    }
-
     for (size_t i = 0; i < k; i++) {
-        partial_sum[i].row = i;
-        partial_sum[i].sum = 0;
-
         matrix[i] = malloc(n * sizeof(pair_t));
         if (matrix[i] == NULL) {
             exit(EXIT_FAILURE);
@@ -268,8 +308,8 @@ int main() {
     }
 
     actor_id_t first_actor;
-    act_t acts_for_first_actor[] = {on_hello_first_actor, on_init_request,
-                                    on_init, on_compute, on_finish};
+    act_t acts_for_first_actor[] = {on_hello_first_actor, on_init,
+                                    on_compute, on_finish, on_cell_done};
     role_t role_for_first_actor = {
             .nprompts = MESSAGES_TYPES,
             .prompts = acts_for_first_actor
@@ -283,8 +323,8 @@ int main() {
         return err;
     }
 
-    act_t acts_for_next_actors[] = {on_hello, on_init_request,
-                                    on_init, on_compute, on_finish};
+    act_t acts_for_next_actors[] = {on_hello, NULL,
+                                    on_compute, on_finish, on_cell_done};
     role_t role_for_next_actors = {
             .nprompts = MESSAGES_TYPES,
             .prompts = acts_for_next_actors
@@ -293,14 +333,12 @@ int main() {
     init_data_t init_data = {
             .col = n - 1,
             .val = 0,
+            .parent = first_actor,
             .role_for_children = &role_for_next_actors
     };
 
-    message_t start_computation = {
-            .message_type = MSG_INIT,
-            .nbytes = sizeof(init_data_t),
-            .data = &init_data
-    };
+    message_t start_computation = {0};
+    message_inline(&start_computation, MSG_INIT, &init_data, sizeof(init_data_t));
 
     if ((err = send_message(first_actor, start_computation))) {
         fprintf(stderr, "Sending message to the first actor failed: %d\n", err);
@@ -314,7 +352,6 @@ int main() {
         free(matrix[i]);
     }
     free(matrix);
-    free(partial_sum);
 
     return 0;
 }
@@ -6,19 +6,15 @@
 #include "cacti.h"
 
 #ifndef MESSAGES_TYPES
-#define MESSAGES_TYPES 4
-#endif
-
-#ifndef MSG_INIT_REQUEST
-#define MSG_INIT_REQUEST 1
+#define MESSAGES_TYPES 3
 #endif
 
 #ifndef MSG_INIT
-#define MSG_INIT 2
+#define MSG_INIT 1
 #endif
 
 #ifndef MSG_FINISH
-#define MSG_FINISH 3
+#define MSG_FINISH 2
 #endif
 
 #define UNUSED(x) (void)(x)
@@ -30,6 +26,7 @@ size_t n;
 typedef struct init_data {
     size_t n;
     ull_t fact;
+    actor_id_t parent;
     role_t *role_for_children;
 } init_data_t;
 
@@ -39,13 +36,9 @@ typedef struct fact_comp {
     actor_id_t id_self;
     actor_id_t parent;
     role_t *role_for_children;
-    init_data_t on_init_request_data;
 } fact_comp_t;
 
-
-void on_hello(void **stateptr, size_t nbytes, void *data) {
-    UNUSED(nbytes);
-
+fact_comp_t *fact_comp_create(void **stateptr) {
     *stateptr = malloc(sizeof(fact_comp_t));
     if (*stateptr == NULL) {
         exit(EXIT_FAILURE);
@@ -53,53 +46,61 @@ void on_hello(void **stateptr, size_t nbytes, void *data) {
 
     fact_comp_t *fact_comp = *stateptr;
     fact_comp->id_self = actor_id_self();
-    fact_comp->parent = (actor_id_t) data;
 
-    message_t init_request = {
-            .message_type = MSG_INIT_REQUEST,
-            .nbytes = sizeof(actor_id_t),
-            .data = &fact_comp->id_self
-    };
+    return fact_comp;
+}
 
+/* Either prints the result, or spawns the next actor of the chain with its
+ * part of the computation already in the hello. */
+void step(fact_comp_t *fact_comp) {
     int err;
-    if ((err = send_message(fact_comp->parent, init_request))) {
-        fprintf(stderr, "Sending message to an actor failed: %d\n", err);
-    }
-}
+    if (fact_comp->n == n) {
+        printf("%llu\n", fact_comp->fact);
 
-void on_hello_first_actor(void **stateptr, size_t nbytes, void *data) {
-    UNUSED(nbytes);
-    UNUSED(data);
+        message_t finish = {
+                .message_type = MSG_FINISH,
+                .nbytes = 0,
+                .data = NULL
+        };
 
-    *stateptr = malloc(sizeof(fact_comp_t));
-    if (*stateptr == NULL) {
-        exit(EXIT_FAILURE);
+        if ((err = send_message(fact_comp->id_self, finish))) {
+            fprintf(stderr, "Sending message to an actor failed: %d\n", err);
+        }
     }
+    else {
+        init_data_t init_data = {
+                .n = fact_comp->n + 1,
+                .fact = fact_comp->fact * (fact_comp->n + 1),
+                .parent = fact_comp->id_self,
+                .role_for_children = fact_comp->role_for_children
+        };
 
-    fact_comp_t *fact_comp = *stateptr;
-    fact_comp->id_self = actor_id_self();
+        if (actor_spawn(fact_comp->role_for_children,
+                        sizeof(init_data_t), &init_data) < 0) {
+            fprintf(stderr, "Spawning an actor failed\n");
+        }
+    }
 }
 
-void on_init_request(void **stateptr, size_t nbytes, void *data) {
+void on_hello(void **stateptr, size_t nbytes, void *data) {
     UNUSED(nbytes);
 
-    actor_id_t *requester = data;
+    init_data_t *init_data = data;
 
-    fact_comp_t *fact_comp = *stateptr;
-    fact_comp->on_init_request_data.n = fact_comp->n + 1;
-    fact_comp->on_init_request_data.fact = fact_comp->fact * (fact_comp->n + 1);
-    fact_comp->on_init_request_data.role_for_children = fact_comp->role_for_children;
-
-    message_t init = {
-            .message_type = MSG_INIT,
-            .nbytes = sizeof(init_data_t),
-            .data = &fact_comp->on_init_request_data
-    };
+    fact_comp_t *fact_comp = fact_comp_create(stateptr);
+    fact_comp->n = init_data->n;
+    fact_comp->fact = init_data->fact;
+    fact_comp->parent = init_data->parent;
+    fact_comp->role_for_children = init_data->role_for_children;
 
-    int err;
-    if ((err = send_message(*requester, init))) {
-        fprintf(stderr, "Sending message to an actor failed: %d\n", err);
-    }
+    step(fact_comp);
+}
+
+void on_hello_first_actor(void **stateptr, size_t nbytes, void *data) {
+    UNUSED(nbytes);
+    UNUSED(data);
+
+    fact_comp_create(stateptr);
 }
 
 void on_init(void **stateptr, size_t nbytes, void *data) {
@@ -112,31 +113,7 @@ void on_init(void **stateptr, size_t nbytes, void *data) {
     fact_comp->fact = init_data->fact;
     fact_comp->role_for_children = init_data->role_for_children;
 
-    int err;
-    if (fact_comp->n == n) {
-        printf("%llu\n", fact_comp->fact);
-
-        message_t finish = {
-                .message_type = MSG_FINISH,
-                .nbytes = 0,
-                .data = NULL
-        };
-
-        if ((err = send_message(fact_comp->id_self, finish))) {
-            fprintf(stderr, "Sending message to an actor failed: %d\n", err);
-        }
-    }
-    else {
-        message_t spawn = {
-                .message_type = MSG_SPAWN,
-                .nbytes = sizeof(role_t),
-                .data = fact_comp->role_for_children
-        };
-
-        if ((err = send_message(fact_comp->id_self, spawn))) {
-            fprintf(stderr, "Sending message to an actor failed: %d\n", err);
-        }
-    }
+    step(fact_comp);
 }
 
 void on_finish(void **stateptr, size_t nbytes, void *data) {
@@ -176,8 +153,7 @@ int main() {
     scanf("%zd", &n);
 
     actor_id_t first_actor;
-    act_t acts_for_first_actor[] = {on_hello_first_actor,
-                                    on_init_request, on_init, on_finish};
+    act_t acts_for_first_actor[] = {on_hello_first_actor, on_init, on_finish};
     role_t role_for_first_actor = {
             .nprompts = MESSAGES_TYPES,
             .prompts = acts_for_first_actor
@@ -191,7 +167,7 @@ int main() {
         return err;
     }
 
-    act_t acts_for_next_actors[] = {on_hello, on_init_request, on_init, on_finish};
+    act_t acts_for_next_actors[] = {on_hello, NULL, on_finish};
     role_t role_for_next_actors = {
             .nprompts = MESSAGES_TYPES,
             .prompts = acts_for_next_actors
@@ -200,14 +176,12 @@ int main() {
     init_data_t init_data = {
             .n = 0,
             .fact = 1,
+            .parent = first_actor,
             .role_for_children = &role_for_next_actors
     };
 
-    message_t start_computation = {
-            .message_type = MSG_INIT,
-            .nbytes = sizeof(init_data_t),
-            .data = &init_data
-    };
+    message_t start_computation = {0};
+    message_inline(&start_computation, MSG_INIT, &init_data, sizeof(init_data_t));
 
     if ((err = send_message(first_actor, start_computation))) {
         fprintf(stderr, "Sending message to the first actor failed: %d\n", err);
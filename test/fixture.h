@@ -0,0 +1,116 @@
+#ifndef FIXTURE_H
+#define FIXTURE_H
+
+/* Setup and teardown shared by the tests. A test includes this header,
+ * defines all_tests and gets the minunit main below. */
+
+#include "minunit.h"
+#include "cacti.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#define WAIT_ROUNDS 5000
+
+int tests_run = 0;
+
+static char *all_tests();
+
+static inline void sleep_msec(long msec)
+{
+    struct timespec pause = {
+            .tv_sec = msec / 1000,
+            .tv_nsec = (msec % 1000) * 1000000L
+    };
+    nanosleep(&pause, NULL);
+}
+
+static inline void send_go_die(actor_id_t actor)
+{
+    message_t go_die = {.message_type = MSG_GODIE};
+    send_message(actor, go_die);
+}
+
+static inline void die_self(void)
+{
+    send_go_die(actor_id_self());
+}
+
+/* The child says hello to the calling actor with its own id. */
+static inline void spawn_child(role_t *role)
+{
+    message_t spawn = {
+            .message_type = MSG_SPAWN,
+            .nbytes = sizeof(role_t),
+            .data = role
+    };
+    send_message(actor_id_self(), spawn);
+}
+
+/* Runs the system of a first actor with the role until all actors die. */
+static inline int run_system(role_t *role)
+{
+    actor_id_t actor;
+    int err = actor_system_create(&actor, role);
+    if (err == 0) {
+        actor_system_join(actor);
+    }
+
+    return err;
+}
+
+/* Like actor_system_create, with a number of workers instead of the
+ * default one per CPU, for tests that need actors to run side by side. */
+static inline int create_system_with_workers(actor_id_t *actor, role_t *role,
+                                             size_t workers)
+{
+    actor_system_config_t config;
+    actor_system_config_default(&config);
+    config.workers = workers;
+
+    return actor_system_create_config(actor, role, &config);
+}
+
+static inline int run_system_with_workers(role_t *role, size_t workers)
+{
+    actor_id_t actor;
+    int err = create_system_with_workers(&actor, role, workers);
+    if (err == 0) {
+        actor_system_join(actor);
+    }
+
+    return err;
+}
+
+/* Waits up to WAIT_ROUNDS milliseconds for the counter to reach expected. */
+static inline bool wait_for(_Atomic size_t *counter, size_t expected)
+{
+    for (size_t round = 0; round < WAIT_ROUNDS; round++) {
+        if (atomic_load(counter) >= expected) {
+            return true;
+        }
+        sleep_msec(1);
+    }
+
+    return false;
+}
+
+int main()
+{
+    char *result = all_tests();
+    if (result != 0)
+    {
+        printf(__BASE_FILE__ ": %s\n", result);
+    }
+    else
+    {
+        printf(__BASE_FILE__ ": ALL TESTS PASSED\n");
+    }
+    printf(__BASE_FILE__ ": Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
+
+#endif
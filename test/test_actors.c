@@ -0,0 +1,183 @@
+#include "fixture.h"
+
+#define MSG_MORE 1
+#define MSG_PING 2
+#define MESSAGES_TYPES 3
+
+#define CHILDREN 3000
+#define SPAWN_ROUND 500
+#define MORTALS 100
+#define INDEX_BITS 32
+
+static role_t role_child;
+static role_t role_mortal;
+
+static size_t spawn_requests;
+static actor_id_t children[CHILDREN];
+static _Atomic size_t children_spawned;
+static _Atomic size_t children_known;
+static _Atomic size_t pinged;
+static _Atomic size_t misdelivered;
+static actor_id_t mortals[MORTALS + 1];
+static _Atomic size_t mortals_known;
+static _Atomic bool mortals_live;
+
+/* Spawns in rounds, so as not to fill its own mailbox with MSG_SPAWN. */
+static void on_more_root(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    for (size_t i = 0; i < SPAWN_ROUND && spawn_requests < CHILDREN; i++) {
+        spawn_child(&role_child);
+        spawn_requests++;
+    }
+    if (spawn_requests < CHILDREN) {
+        message_t more = {.message_type = MSG_MORE};
+        send_message(actor_id_self(), more);
+    }
+}
+
+static void on_hello_root(void **stateptr, size_t nbytes, void *data)
+{
+    on_more_root(stateptr, nbytes, data);
+}
+
+static void on_hello_child(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    children[atomic_fetch_add(&children_spawned, 1)] = actor_id_self();
+    atomic_fetch_add(&children_known, 1);
+}
+
+static void on_ping_child(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+
+    if ((actor_id_t) data != actor_id_self()) {
+        atomic_fetch_add(&misdelivered, 1);
+    }
+    atomic_fetch_add(&pinged, 1);
+    die_self();
+}
+
+static void on_more_recycler(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    spawn_child(&role_mortal);
+}
+
+static void on_hello_mortal(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    mortals[atomic_load(&mortals_known)] = actor_id_self();
+    atomic_fetch_add(&mortals_known, 1);
+    if (!atomic_load(&mortals_live)) {
+        die_self();
+    }
+}
+
+static act_t acts_root[] = {on_hello_root, on_more_root, NULL};
+static role_t role_root = {.nprompts = MESSAGES_TYPES, .prompts = acts_root};
+
+static act_t acts_child[] = {on_hello_child, NULL, on_ping_child};
+static role_t role_child = {.nprompts = MESSAGES_TYPES, .prompts = acts_child};
+
+static act_t acts_recycler[] = {on_more_recycler, on_more_recycler, NULL};
+static role_t role_recycler = {.nprompts = MESSAGES_TYPES, .prompts = acts_recycler};
+
+static act_t acts_mortal[] = {on_hello_mortal, NULL, on_ping_child};
+static role_t role_mortal = {.nprompts = MESSAGES_TYPES, .prompts = acts_mortal};
+
+/* More actors than fit in the first segment of the table, each reached
+ * through its own id. */
+static char *every_id_reaches_its_actor()
+{
+    actor_id_t root;
+    mu_assert("actor system create failed", actor_system_create(&root, &role_root) == 0);
+    mu_assert("children were not spawned", wait_for(&children_known, CHILDREN));
+
+    for (size_t i = 0; i < CHILDREN; i++) {
+        message_t ping = {.message_type = MSG_PING, .data = (void *) children[i]};
+        mu_assert("sending failed", send_message(children[i], ping) == 0);
+    }
+    message_t ping = {.message_type = MSG_PING};
+    mu_assert("sent to an actor that was never spawned",
+              send_message(CAST_LIMIT, ping) == -2);
+    mu_assert("children were not pinged", wait_for(&pinged, CHILDREN));
+
+    send_go_die(root);
+    actor_system_join(root);
+
+    mu_assert("message reached another actor", atomic_load(&misdelivered) == 0);
+    return 0;
+}
+
+static bool has_index_of(actor_id_t actor, actor_id_t other)
+{
+    return (actor & ((1L << INDEX_BITS) - 1)) == (other & ((1L << INDEX_BITS) - 1));
+}
+
+/* Actors spawned one after another's death take over its table entry, but
+ * not its id: a message to the dead one is refused. */
+static char *dead_actors_are_reclaimed()
+{
+    actor_id_t recycler;
+    mu_assert("actor system create failed",
+              actor_system_create(&recycler, &role_recycler) == 0);
+
+    message_t more = {.message_type = MSG_MORE};
+    message_t ping = {.message_type = MSG_PING};
+    for (size_t i = 0; i <= MORTALS; i++) {
+        mu_assert("mortal was not spawned", wait_for(&mortals_known, i + 1));
+        if (i == MORTALS) {
+            break;
+        }
+        while (send_message(mortals[i], ping) == 0) {
+            sleep_msec(1);
+        }
+        if (i == MORTALS - 1) {
+            atomic_store(&mortals_live, true);
+        }
+        send_message(recycler, more);
+    }
+
+    actor_id_t live = mortals[MORTALS];
+    size_t reused = 0;
+    for (size_t i = 0; i < MORTALS; i++) {
+        mu_assert("id was given out twice", mortals[i] != live);
+        if (has_index_of(mortals[i], live)) {
+            reused++;
+            mu_assert("stale id reached a live actor", send_message(mortals[i], ping) == -1);
+        }
+    }
+    size_t pinged_before = atomic_load(&pinged);
+    message_t own = {.message_type = MSG_PING, .data = (void *) live};
+    mu_assert("sending to the live actor failed", send_message(live, own) == 0);
+    mu_assert("live actor was not pinged", wait_for(&pinged, pinged_before + 1));
+
+    send_go_die(recycler);
+    actor_system_join(recycler);
+
+    mu_assert("table entries were not reused", reused > 0);
+    mu_assert("message reached another actor", atomic_load(&misdelivered) == 0);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(every_id_reaches_its_actor);
+    mu_run_test(dead_actors_are_reclaimed);
+    return 0;
+}
@@ -0,0 +1,155 @@
+#include "fixture.h"
+
+#define MSG_HOLD 1
+#define MSG_FILL 2
+#define MSG_ROOM 3
+#define MSG_READY 4
+#define MESSAGES_TYPES 5
+
+#define WORKERS 2
+
+static role_t role_holder;
+
+static actor_id_t holder = -1;
+static _Atomic bool hold = true;
+static size_t filled;
+static int refused_try = 0;
+static int refused_async = 0;
+static size_t released_when_refused = 1;
+static _Atomic size_t released;
+static _Atomic size_t fills_handled;
+static actor_id_t room_data = -1;
+static size_t rooms;
+
+static void release_fill(void *data)
+{
+    (void) data;
+
+    atomic_fetch_add(&released, 1);
+}
+
+static void on_hello_root(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    spawn_child(&role_holder);
+}
+
+/* Fills the mailbox of the holder, which is stuck in its first message,
+ * then asks to be told when there is room again. */
+static void on_ready_root(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+
+    holder = (actor_id_t) data;
+    message_t hold_message = {.message_type = MSG_HOLD};
+    send_message(holder, hold_message);
+
+    message_t fill = {.message_type = MSG_FILL, .release = release_fill};
+    int err;
+    while ((err = try_send_message(holder, fill)) == 0) {
+        filled++;
+    }
+    refused_try = err;
+    released_when_refused = atomic_load(&released);
+
+    refused_async = send_message_async(holder, fill, MSG_ROOM);
+    atomic_store(&hold, false);
+}
+
+static void on_room_root(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+
+    rooms++;
+    room_data = (actor_id_t) data;
+
+    send_go_die(holder);
+    die_self();
+}
+
+static void on_hello_holder(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+
+    message_t ready = {.message_type = MSG_READY, .data = (void *) actor_id_self()};
+    send_message((actor_id_t) data, ready);
+}
+
+static void on_hold(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    while (atomic_load(&hold)) {
+        sleep_msec(1);
+    }
+}
+
+static void on_fill(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    atomic_fetch_add(&fills_handled, 1);
+}
+
+static void on_hello_filled(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+}
+
+static act_t acts_root[] = {on_hello_root, NULL, NULL, on_room_root, on_ready_root};
+static role_t role_root = {.nprompts = MESSAGES_TYPES, .prompts = acts_root};
+
+static act_t acts_holder[] = {on_hello_holder, on_hold, on_fill, NULL, NULL};
+static role_t role_holder = {.nprompts = MESSAGES_TYPES, .prompts = acts_holder};
+
+static act_t acts_filled[] = {on_hello_filled, NULL, on_fill, NULL, NULL};
+static role_t role_filled = {.nprompts = MESSAGES_TYPES, .prompts = acts_filled};
+
+static char *full_mailbox_notifies_the_sender()
+{
+    mu_assert("actor system create failed",
+              run_system_with_workers(&role_root, WORKERS) == 0);
+
+    /* The hold message takes a place until the holder has started it. */
+    mu_assert("mailbox did not fill up to its limit",
+              filled == ACTOR_QUEUE_LIMIT || filled == ACTOR_QUEUE_LIMIT - 1);
+    mu_assert("try_send_message blocked or failed", refused_try == -3);
+    mu_assert("refused message was released", released_when_refused == 0);
+    mu_assert("send_message_async did not report a full mailbox", refused_async == -3);
+    mu_assert("sender was not notified exactly once", rooms == 1);
+    mu_assert("notification does not name the full actor", room_data == holder);
+    mu_assert("not every message got through", atomic_load(&fills_handled) == filled);
+    mu_assert("handled messages were not released", atomic_load(&released) == filled);
+    return 0;
+}
+
+static char *try_send_after_join_fails()
+{
+    actor_id_t actor;
+    mu_assert("actor system create failed", actor_system_create(&actor, &role_filled) == 0);
+    send_go_die(actor);
+    actor_system_join(actor);
+
+    message_t fill = {.message_type = MSG_FILL};
+    mu_assert("sent to an actor of a joined system", try_send_message(actor, fill) == -2);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(full_mailbox_notifies_the_sender);
+    mu_run_test(try_send_after_join_fails);
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include "fixture.h"
+
+#include <stdint.h>
+
+#define MSG_SEQ 1
+#define MESSAGES_TYPES 2
+
+#define BATCH 100
+#define LEADING 3
+#define DEAD_ACTOR 1000
+
+static int sent_all = -1;
+static int sent_leading = -1;
+static int sent_to_nobody = 0;
+static size_t received;
+static bool in_order = true;
+static _Atomic size_t released;
+
+static void release_seq(void *data)
+{
+    (void) data;
+
+    atomic_fetch_add(&released, 1);
+}
+
+/* A batch, then a batch whose lane changes after LEADING messages, then one
+ * to an actor that does not exist. */
+static void on_hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    message_t messages[BATCH];
+    for (size_t i = 0; i < BATCH; i++) {
+        messages[i] = (message_t) {
+                .message_type = MSG_SEQ,
+                .data = (void *) (uintptr_t) i,
+                .release = release_seq
+        };
+    }
+    sent_all = send_messages(actor_id_self(), messages, BATCH);
+
+    for (size_t i = 0; i < LEADING + 1; i++) {
+        messages[i].data = (void *) (uintptr_t) (BATCH + i);
+    }
+    messages[LEADING].flags = MSG_FLAG_URGENT;
+    sent_leading = send_messages(actor_id_self(), messages, LEADING + 1);
+
+    sent_to_nobody = send_messages(DEAD_ACTOR, messages, BATCH);
+}
+
+static void on_seq(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+
+    if ((uintptr_t) data != received) {
+        in_order = false;
+    }
+
+    if (++received == BATCH + LEADING) {
+        die_self();
+    }
+}
+
+static act_t acts[] = {on_hello, on_seq};
+static role_t role = {.nprompts = MESSAGES_TYPES, .prompts = acts};
+
+static char *batches_arrive_in_order()
+{
+    mu_assert("actor system create failed", run_system(&role) == 0);
+
+    mu_assert("batch was not sent whole", sent_all == BATCH);
+    mu_assert("messages of another lane were sent with the batch",
+              sent_leading == LEADING);
+    mu_assert("batch to a missing actor did not fail", sent_to_nobody == -2);
+    mu_assert("not every message arrived", received == BATCH + LEADING);
+    mu_assert("messages arrived out of order", in_order);
+    /* The handled messages, and the whole batch refused with -2. */
+    mu_assert("messages were not released",
+              atomic_load(&released) == BATCH + LEADING + BATCH);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(batches_arrive_in_order);
+    return 0;
+}
@@ -0,0 +1,176 @@
+#include "fixture.h"
+
+#define MSG_BLOCK 1
+#define MSG_AFTER 2
+#define MSG_PONG 3
+#define MESSAGES_TYPES 4
+
+#define WORKERS 3
+#define SPINNERS (WORKERS - 1)
+
+static role_t role_spinner;
+static role_t role_blocker;
+static role_t role_always;
+
+static actor_id_t root = -1;
+static actor_id_t blocker = -1;
+static actor_id_t always = -1;
+static _Atomic size_t known;
+static _Atomic size_t spinning;
+static _Atomic bool stop;
+static _Atomic size_t ponged;
+static _Atomic bool block_waited;
+static _Atomic bool block_self;
+static _Atomic bool block_done;
+static _Atomic bool after_followed_block;
+static _Atomic bool always_waited;
+
+static void on_hello_root(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    root = actor_id_self();
+    for (size_t i = 0; i < SPINNERS; i++) {
+        spawn_child(&role_spinner);
+    }
+    spawn_child(&role_blocker);
+    spawn_child(&role_always);
+}
+
+static void on_pong_root(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    atomic_fetch_add(&ponged, 1);
+}
+
+/* Keeps a worker busy until told to stop. */
+static void on_hello_spinner(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    atomic_fetch_add(&spinning, 1);
+    while (!atomic_load(&stop)) {
+        sleep_msec(1);
+    }
+    die_self();
+}
+
+static void on_hello_blocker(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    blocker = actor_id_self();
+    atomic_fetch_add(&known, 1);
+}
+
+/* Waits for the last free worker, which it would be holding itself if it
+ * ran there. */
+static bool wait_for_pong(size_t expected)
+{
+    message_t pong = {.message_type = MSG_PONG};
+    send_message(root, pong);
+
+    return wait_for(&ponged, expected);
+}
+
+static void on_block(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    atomic_store(&block_self, actor_id_self() == blocker);
+    atomic_store(&block_waited, wait_for_pong(1));
+    atomic_store(&block_done, true);
+}
+
+static void on_after(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    atomic_store(&after_followed_block, atomic_load(&block_done));
+    die_self();
+}
+
+/* Every handler of the role blocks, its hello included. */
+static void on_hello_always(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    always = actor_id_self();
+    atomic_fetch_add(&known, 1);
+}
+
+static void on_block_always(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    atomic_store(&always_waited, wait_for_pong(2));
+    die_self();
+}
+
+static act_t acts_root[] = {on_hello_root, NULL, NULL, on_pong_root};
+static role_t role_root = {.nprompts = MESSAGES_TYPES, .prompts = acts_root};
+
+static act_t acts_spinner[] = {on_hello_spinner, NULL, NULL, NULL};
+static role_t role_spinner = {.nprompts = MESSAGES_TYPES, .prompts = acts_spinner};
+
+static act_t acts_blocker[] = {on_hello_blocker, on_block, on_after, NULL};
+static role_t role_blocker = {.nprompts = MESSAGES_TYPES, .prompts = acts_blocker};
+
+static act_t acts_always[] = {on_hello_always, on_block_always, NULL, NULL};
+static role_t role_always = {
+        .nprompts = MESSAGES_TYPES,
+        .prompts = acts_always,
+        .flags = ROLE_FLAG_BLOCKING
+};
+
+/* With all workers but one held by spinners, a blocking handler that took
+ * the last one would never see its pong. */
+static char *blocking_handlers_leave_the_worker()
+{
+    actor_id_t first_actor;
+    mu_assert("actor system create failed",
+              create_system_with_workers(&first_actor, &role_root, WORKERS) == 0);
+    mu_assert("actors were not spawned", wait_for(&known, 2));
+    mu_assert("spinners did not start", wait_for(&spinning, SPINNERS));
+
+    message_t block = {.message_type = MSG_BLOCK, .flags = MSG_FLAG_BLOCKING};
+    message_t after = {.message_type = MSG_AFTER};
+    send_message(blocker, block);
+    send_message(blocker, after);
+    mu_assert("blocking message was not handled", wait_for(&ponged, 1));
+    send_message(always, block);
+    mu_assert("blocking role was not handled", wait_for(&ponged, 2));
+
+    atomic_store(&stop, true);
+    send_go_die(first_actor);
+    actor_system_join(first_actor);
+
+    mu_assert("blocking message was handled on the worker", atomic_load(&block_waited));
+    mu_assert("blocking handler does not know its actor", atomic_load(&block_self));
+    mu_assert("next message overtook the blocking one", atomic_load(&after_followed_block));
+    mu_assert("blocking role was handled on the worker", atomic_load(&always_waited));
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(blocking_handlers_leave_the_worker);
+    return 0;
+}
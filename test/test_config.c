@@ -0,0 +1,181 @@
+#define _GNU_SOURCE
+
+#include "fixture.h"
+
+#include <dirent.h>
+#include <limits.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MESSAGES_TYPES 1
+
+#define WORKERS 2
+#define THREAD_NAME "tcfg"
+#define STACK_SIZE (4 << 20)
+
+static char names[WORKERS][16];
+static size_t stack_sizes[WORKERS];
+static _Atomic size_t started;
+static _Atomic size_t both_started;
+
+static role_t role_worker;
+
+static void on_hello_root(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    for (size_t i = 0; i < WORKERS; i++) {
+        spawn_child(&role_worker);
+    }
+}
+
+/* Holds its worker until the other one has started too, so that each
+ * runs on a worker of its own. */
+static void on_hello_worker(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    size_t index = atomic_fetch_add(&started, 1);
+    pthread_getname_np(pthread_self(), names[index], sizeof(names[index]));
+
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+        pthread_attr_getstacksize(&attr, &stack_sizes[index]);
+        pthread_attr_destroy(&attr);
+    }
+
+    if (wait_for(&started, WORKERS)) {
+        atomic_fetch_add(&both_started, 1);
+    }
+    die_self();
+}
+
+static void on_hello_idle(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+}
+
+static act_t acts_root[] = {on_hello_root};
+static role_t role_root = {.nprompts = MESSAGES_TYPES, .prompts = acts_root};
+
+static act_t acts_worker[] = {on_hello_worker};
+static role_t role_worker = {.nprompts = MESSAGES_TYPES, .prompts = acts_worker};
+
+static act_t acts_idle[] = {on_hello_idle};
+static role_t role_idle = {.nprompts = MESSAGES_TYPES, .prompts = acts_idle};
+
+/* Counts the threads of the process named prefix-<worker index>. */
+static size_t count_workers(const char *prefix)
+{
+    DIR *tasks = opendir("/proc/self/task");
+    if (tasks == NULL) {
+        return 0;
+    }
+
+    size_t count = 0;
+    size_t length = strlen(prefix);
+    struct dirent *task;
+    while ((task = readdir(tasks)) != NULL) {
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "/proc/self/task/%s/comm", task->d_name);
+        FILE *comm = fopen(path, "r");
+        if (comm == NULL) {
+            continue;
+        }
+
+        char name[32] = "";
+        if (fgets(name, sizeof(name), comm) != NULL
+            && strncmp(name, prefix, length) == 0
+            && name[length] == '-' && name[length + 1] >= '0' && name[length + 1] <= '9') {
+            count++;
+        }
+        fclose(comm);
+    }
+    closedir(tasks);
+
+    return count;
+}
+
+/* Workers may name themselves only once they run. */
+static size_t wait_for_workers(const char *prefix, size_t expected)
+{
+    size_t count = count_workers(prefix);
+    for (size_t round = 0; count != expected && round < WAIT_ROUNDS; round++) {
+        sleep_msec(1);
+        count = count_workers(prefix);
+    }
+
+    return count;
+}
+
+static char *configured_workers_run_actors()
+{
+    actor_system_config_t config;
+    actor_system_config_default(&config);
+    config.workers = WORKERS;
+    config.thread_name = THREAD_NAME;
+    config.stack_size = STACK_SIZE;
+
+    actor_id_t root;
+    mu_assert("actor system create failed",
+              actor_system_create_config(&root, &role_root, &config) == 0);
+    size_t workers = wait_for_workers(THREAD_NAME, WORKERS);
+    send_go_die(root);
+    actor_system_join(root);
+
+    mu_assert("wrong number of workers", workers == WORKERS);
+    mu_assert("workers did not run side by side", atomic_load(&both_started) == WORKERS);
+    mu_assert("actors ran on the same worker", strcmp(names[0], names[1]) != 0);
+    for (size_t i = 0; i < WORKERS; i++) {
+        mu_assert("worker was not named",
+                  strncmp(names[i], THREAD_NAME "-", strlen(THREAD_NAME "-")) == 0);
+        mu_assert("worker did not get the stack size", stack_sizes[i] >= STACK_SIZE);
+    }
+    return 0;
+}
+
+static char *invalid_configs_are_rejected()
+{
+    actor_system_config_t config;
+    actor_system_config_default(&config);
+    config.stack_size = 1;
+
+    actor_id_t root;
+    mu_assert("stack below PTHREAD_STACK_MIN was accepted",
+              actor_system_create_config(&root, &role_idle, &config) != 0);
+    return 0;
+}
+
+/* POOL_SIZE defaults to 0, one worker per online CPU. */
+static char *default_is_a_worker_per_cpu()
+{
+    actor_system_config_t config;
+    actor_system_config_default(&config);
+    mu_assert("default is not POOL_SIZE", config.workers == POOL_SIZE);
+    mu_assert("POOL_SIZE is not 0", POOL_SIZE == 0);
+
+    actor_id_t root;
+    mu_assert("actor system create failed", actor_system_create(&root, &role_idle) == 0);
+    size_t cpus = (size_t) sysconf(_SC_NPROCESSORS_ONLN);
+    size_t workers = wait_for_workers(config.thread_name, cpus);
+    send_go_die(root);
+    actor_system_join(root);
+
+    mu_assert("not a worker per online CPU", workers == cpus);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(configured_workers_run_actors);
+    mu_run_test(invalid_configs_are_rejected);
+    mu_run_test(default_is_a_worker_per_cpu);
+    return 0;
+}
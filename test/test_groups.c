@@ -0,0 +1,153 @@
+#include "fixture.h"
+
+#include <string.h>
+
+#define MSG_PING 1
+#define MESSAGES_TYPES 2
+
+#define MEMBERS 8
+
+#define GREETING "hello, group"
+
+static role_t role_member;
+
+static actor_id_t members[MEMBERS];
+static _Atomic size_t members_spawned;
+static _Atomic size_t members_known;
+static _Atomic size_t pinged;
+static _Atomic size_t wrong_payload;
+static _Atomic size_t custom_released;
+
+static void on_hello_root(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    for (size_t i = 0; i < MEMBERS; i++) {
+        spawn_child(&role_member);
+    }
+}
+
+/* Probes sent to find out whether a member is dead arrive as further
+ * hellos, which must not register it again. */
+static void on_hello_member(void **stateptr, size_t nbytes, void *data)
+{
+    (void) nbytes;
+    (void) data;
+
+    if (*stateptr != NULL) {
+        return;
+    }
+    *stateptr = members;
+
+    members[atomic_fetch_add(&members_spawned, 1)] = actor_id_self();
+    atomic_fetch_add(&members_known, 1);
+}
+
+/* Every member sees the same payload. */
+static void on_ping(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+
+    if (nbytes != sizeof(GREETING) || strcmp(data, GREETING) != 0) {
+        atomic_fetch_add(&wrong_payload, 1);
+    }
+    atomic_fetch_add(&pinged, 1);
+}
+
+static void release_custom(void *data)
+{
+    (void) data;
+
+    atomic_fetch_add(&custom_released, 1);
+}
+
+static act_t acts_root[] = {on_hello_root, NULL};
+static role_t role_root = {.nprompts = MESSAGES_TYPES, .prompts = acts_root};
+
+static act_t acts_member[] = {on_hello_member, on_ping};
+static role_t role_member = {.nprompts = MESSAGES_TYPES, .prompts = acts_member};
+
+static message_t greeting(void)
+{
+    message_t ping = {
+            .message_type = MSG_PING,
+            .nbytes = sizeof(GREETING),
+            .data = message_payload_alloc(sizeof(GREETING)),
+            .release = message_payload_release
+    };
+    memcpy(ping.data, GREETING, sizeof(GREETING));
+
+    return ping;
+}
+
+static bool pinged_exactly(size_t expected)
+{
+    return wait_for(&pinged, expected) && atomic_load(&pinged) == expected;
+}
+
+/* Driven from the main thread. */
+static char *broadcast_reaches_current_members()
+{
+    actor_id_t root;
+    mu_assert("actor system create failed", actor_system_create(&root, &role_root) == 0);
+    mu_assert("members were not spawned", wait_for(&members_known, MEMBERS));
+
+    group_id_t group = actor_group("members");
+    mu_assert("group was not created", group >= 0);
+    mu_assert("same name gave another group", actor_group("members") == group);
+    mu_assert("another name gave the same group", actor_group("others") != group);
+    mu_assert("group without a name", actor_group(NULL) == -1);
+
+    for (size_t i = 0; i < MEMBERS; i++) {
+        mu_assert("joining failed", actor_group_join(group, members[i]) == 0);
+    }
+    mu_assert("joining twice failed", actor_group_join(group, members[0]) == 0);
+    mu_assert("joining a missing group", actor_group_join(group + 100, members[0]) == -2);
+
+    size_t expected = MEMBERS;
+    mu_assert("broadcast missed members", broadcast_message(group, greeting()) == MEMBERS);
+    mu_assert("members were not pinged once each", pinged_exactly(expected));
+
+    mu_assert("leaving failed", actor_group_leave(group, members[1]) == 0);
+    mu_assert("left twice", actor_group_leave(group, members[1]) == -1);
+    expected += MEMBERS - 1;
+    mu_assert("broadcast reached a member that left",
+              broadcast_message(group, greeting()) == MEMBERS - 1);
+    mu_assert("members were not pinged once each", pinged_exactly(expected));
+
+    /* The dead member is dropped by the next broadcast. */
+    send_go_die(members[2]);
+    message_t probe = {.message_type = MSG_HELLO};
+    while (try_send_message(members[2], probe) == 0) {
+        sleep_msec(1);
+    }
+    expected += MEMBERS - 2;
+    mu_assert("broadcast reached a dead member",
+              broadcast_message(group, greeting()) == MEMBERS - 2);
+    mu_assert("dead member was kept in the group",
+              actor_group_leave(group, members[2]) == -1);
+    mu_assert("members were not pinged once each", pinged_exactly(expected));
+
+    message_t custom = {.message_type = MSG_PING, .release = release_custom};
+    mu_assert("broadcast of a payload without a reference count",
+              broadcast_message(group, custom) == -1);
+    mu_assert("refused message was not released", atomic_load(&custom_released) == 1);
+    mu_assert("broadcast to a missing group", broadcast_message(group + 100, greeting()) == -2);
+
+    message_t go_die = {.message_type = MSG_GODIE};
+    mu_assert("members did not die", broadcast_message(group, go_die) == MEMBERS - 2);
+    send_go_die(members[1]);
+    send_go_die(root);
+    actor_system_join(root);
+
+    mu_assert("payload was corrupted", atomic_load(&wrong_payload) == 0);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(broadcast_reaches_current_members);
+    return 0;
+}
@@ -0,0 +1,352 @@
+#include "fixture.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MSG_HOLD 1
+#define MSG_SEQ 2
+#define MSG_BURST 3
+#define MSG_SPRAY 4
+#define MSG_DONE 5
+#define MESSAGES_TYPES 6
+
+#define SENT (3 * ACTOR_QUEUE_LIMIT)
+#define BLOCKED_MSEC 20
+#define PRODUCERS 4
+#define TARGETS 64
+#define SPRAYED 20000
+
+static actor_id_t consumer = -1;
+static _Atomic bool hold = true;
+static _Atomic size_t holding;
+static _Atomic size_t sent;
+static size_t received;
+static bool in_order = true;
+static _Atomic size_t bursts_received;
+static bool bursts_in_order = true;
+static role_t role_target;
+static actor_id_t targets[TARGETS];
+static _Atomic size_t targets_spawned;
+static _Atomic size_t targets_known;
+static _Atomic size_t sprays_received;
+static _Atomic size_t sprays_out_of_order;
+static _Atomic size_t pauses;
+static _Atomic size_t resumed;
+static _Atomic size_t fillers_received;
+static _Atomic size_t latecomer_sent;
+
+static void on_hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+}
+
+static void on_hold(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    atomic_fetch_add(&holding, 1);
+    while (atomic_load(&hold)) {
+        sleep_msec(1);
+    }
+}
+
+static void on_seq(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+
+    if ((uintptr_t) data != received) {
+        in_order = false;
+    }
+
+    if (++received == SENT) {
+        die_self();
+    }
+}
+
+static void on_burst(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+
+    if ((uintptr_t) data != atomic_load(&bursts_received)) {
+        bursts_in_order = false;
+    }
+    atomic_fetch_add(&bursts_received, 1);
+}
+
+static void on_hello_sprayed(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    for (size_t i = 0; i < TARGETS; i++) {
+        spawn_child(&role_target);
+    }
+}
+
+/* Keeps the next sequence number it expects from every producer. */
+static void on_hello_target(void **stateptr, size_t nbytes, void *data)
+{
+    (void) nbytes;
+    (void) data;
+
+    *stateptr = calloc(PRODUCERS, sizeof(uintptr_t));
+    targets[atomic_fetch_add(&targets_spawned, 1)] = actor_id_self();
+    atomic_fetch_add(&targets_known, 1);
+}
+
+static void on_spray(void **stateptr, size_t nbytes, void *data)
+{
+    (void) nbytes;
+
+    uintptr_t *expected = *stateptr;
+    uintptr_t producer = (uintptr_t) data % PRODUCERS;
+    uintptr_t seq = (uintptr_t) data / PRODUCERS;
+    if (expected == NULL || expected[producer] != seq) {
+        atomic_fetch_add(&sprays_out_of_order, 1);
+    }
+    else {
+        expected[producer] = seq + 1;
+    }
+    atomic_fetch_add(&sprays_received, 1);
+}
+
+static void on_done_target(void **stateptr, size_t nbytes, void *data)
+{
+    (void) nbytes;
+    (void) data;
+
+    free(*stateptr);
+    *stateptr = NULL;
+    die_self();
+}
+
+/* The n-th pause lasts until resumed reaches n. */
+static void on_pause(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    size_t pause = atomic_fetch_add(&pauses, 1) + 1;
+    while (atomic_load(&resumed) < pause) {
+        sleep_msec(1);
+    }
+}
+
+static void on_filler(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    atomic_fetch_add(&fillers_received, 1);
+}
+
+static act_t acts[] = {on_hello, on_hold, on_seq, on_burst, NULL, NULL};
+static role_t role = {.nprompts = MESSAGES_TYPES, .prompts = acts};
+
+static act_t acts_paused[] = {on_hello, on_pause, on_filler, NULL, NULL, NULL};
+static role_t role_paused = {.nprompts = MESSAGES_TYPES, .prompts = acts_paused};
+
+static act_t acts_sprayed[] = {on_hello_sprayed, NULL, NULL, NULL, NULL, NULL};
+static role_t role_sprayed = {.nprompts = MESSAGES_TYPES, .prompts = acts_sprayed};
+
+static act_t acts_target[] = {on_hello_target, NULL, NULL, NULL, on_spray, on_done_target};
+static role_t role_target = {.nprompts = MESSAGES_TYPES, .prompts = acts_target};
+
+static void *produce(void *arg)
+{
+    (void) arg;
+
+    for (size_t i = 0; i < SENT; i++) {
+        message_t seq = {.message_type = MSG_SEQ, .data = (void *) (uintptr_t) i};
+        if (send_message(consumer, seq) == 0) {
+            atomic_fetch_add(&sent, 1);
+        }
+    }
+
+    return NULL;
+}
+
+/* A sender that finds the mailbox full waits for room instead of failing,
+ * and gets through once the actor drains it. */
+static char *blocked_senders_get_through()
+{
+    mu_assert("actor system create failed", actor_system_create(&consumer, &role) == 0);
+
+    message_t hold_message = {.message_type = MSG_HOLD};
+    send_message(consumer, hold_message);
+    mu_assert("actor did not start holding", wait_for(&holding, 1));
+
+    pthread_t producer;
+    mu_assert("producer did not start",
+              pthread_create(&producer, NULL, produce, NULL) == 0);
+    mu_assert("mailbox did not fill up", wait_for(&sent, ACTOR_QUEUE_LIMIT));
+    sleep_msec(BLOCKED_MSEC);
+    size_t sent_while_held = atomic_load(&sent);
+
+    atomic_store(&hold, false);
+    pthread_join(producer, NULL);
+    actor_system_join(consumer);
+
+    mu_assert("sender was not stopped at the limit", sent_while_held == ACTOR_QUEUE_LIMIT);
+    mu_assert("blocked sender failed", atomic_load(&sent) == SENT);
+    mu_assert("not every message arrived", received == SENT);
+    mu_assert("messages arrived out of order", in_order);
+    return 0;
+}
+
+static void *send_latecomer(void *arg)
+{
+    message_t filler = {.message_type = MSG_SEQ};
+    if (send_message(*(actor_id_t *) arg, filler) == 0) {
+        atomic_store(&latecomer_sent, 1);
+    }
+
+    return NULL;
+}
+
+/* A sender blocked on a full mailbox gets the first place freed, without
+ * waiting for the actor to drain half of it. The actor pauses again two
+ * messages after the mailbox was full. */
+static char *blocked_sender_gets_a_freed_place()
+{
+    actor_id_t actor;
+    mu_assert("actor system create failed", actor_system_create(&actor, &role_paused) == 0);
+
+    message_t pause = {.message_type = MSG_HOLD};
+    message_t filler = {.message_type = MSG_SEQ};
+    send_message(actor, pause);
+    mu_assert("actor did not pause", wait_for(&pauses, 1));
+
+    send_message(actor, filler);
+    send_message(actor, pause);
+    size_t fillers = 1;
+    while (try_send_message(actor, filler) == 0) {
+        fillers++;
+    }
+    mu_assert("mailbox did not fill up", fillers == ACTOR_QUEUE_LIMIT - 1);
+
+    pthread_t latecomer;
+    mu_assert("sender did not start",
+              pthread_create(&latecomer, NULL, send_latecomer, &actor) == 0);
+    sleep_msec(BLOCKED_MSEC);
+    mu_assert("sender got past a full mailbox", atomic_load(&latecomer_sent) == 0);
+
+    atomic_store(&resumed, 1);
+    mu_assert("actor did not pause again", wait_for(&pauses, 2));
+    mu_assert("blocked sender waited for the mailbox to drain",
+              wait_for(&latecomer_sent, 1));
+
+    atomic_store(&resumed, 2);
+    pthread_join(latecomer, NULL);
+    send_go_die(actor);
+    actor_system_join(actor);
+
+    mu_assert("messages were lost", atomic_load(&fillers_received) == fillers + 1);
+    return 0;
+}
+
+/* Bursts of every size, each queued up while the actor is held and
+ * drained before the next, so that the mailbox grows and shrinks. */
+static char *mailboxes_grow_and_shrink()
+{
+    static const size_t bursts[] = {
+            1, ACTOR_QUEUE_LIMIT, 2, 1, ACTOR_QUEUE_LIMIT / 2, 3, 1, 1,
+            ACTOR_QUEUE_LIMIT - 1, 5, 1
+    };
+
+    actor_id_t actor;
+    mu_assert("actor system create failed", actor_system_create(&actor, &role) == 0);
+
+    size_t held = atomic_load(&holding);
+    size_t sent_bursts = 0;
+    for (size_t i = 0; i < sizeof(bursts) / sizeof(bursts[0]); i++) {
+        atomic_store(&hold, true);
+        message_t hold_message = {.message_type = MSG_HOLD};
+        send_message(actor, hold_message);
+        mu_assert("actor did not start holding", wait_for(&holding, held + i + 1));
+
+        for (size_t j = 0; j < bursts[i]; j++) {
+            message_t burst = {
+                    .message_type = MSG_BURST,
+                    .data = (void *) (uintptr_t) sent_bursts++
+            };
+            mu_assert("sending failed", send_message(actor, burst) == 0);
+        }
+        atomic_store(&hold, false);
+        mu_assert("burst was not drained", wait_for(&bursts_received, sent_bursts));
+    }
+
+    send_go_die(actor);
+    actor_system_join(actor);
+
+    mu_assert("messages were lost", atomic_load(&bursts_received) == sent_bursts);
+    mu_assert("messages arrived out of order", bursts_in_order);
+    return 0;
+}
+
+/* Every producer sends its own sequence, round robin over the targets,
+ * with its index in the low bits of the data. */
+static void *spray(void *arg)
+{
+    uintptr_t producer = (uintptr_t) arg;
+    for (uintptr_t i = 0; i < SPRAYED; i++) {
+        uintptr_t seq = i / TARGETS;
+        message_t message = {
+                .message_type = MSG_SPRAY,
+                .data = (void *) (seq * PRODUCERS + producer)
+        };
+        send_message(targets[i % TARGETS], message);
+    }
+
+    return NULL;
+}
+
+/* Producers and consumers of many mailboxes at once, each producer's
+ * messages arriving in the order they were sent. */
+static char *producers_spray_many_actors()
+{
+    actor_id_t root;
+    mu_assert("actor system create failed",
+              actor_system_create(&root, &role_sprayed) == 0);
+    mu_assert("targets were not spawned", wait_for(&targets_known, TARGETS));
+
+    pthread_t producers[PRODUCERS];
+    for (uintptr_t i = 0; i < PRODUCERS; i++) {
+        mu_assert("producer did not start",
+                  pthread_create(&producers[i], NULL, spray, (void *) i) == 0);
+    }
+    for (size_t i = 0; i < PRODUCERS; i++) {
+        pthread_join(producers[i], NULL);
+    }
+    mu_assert("messages were lost", wait_for(&sprays_received, PRODUCERS * SPRAYED));
+
+    message_t done = {.message_type = MSG_DONE};
+    for (size_t i = 0; i < TARGETS; i++) {
+        send_message(targets[i], done);
+    }
+    send_go_die(root);
+    actor_system_join(root);
+
+    mu_assert("messages of a producer were reordered",
+              atomic_load(&sprays_out_of_order) == 0);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(blocked_senders_get_through);
+    mu_run_test(blocked_sender_gets_a_freed_place);
+    mu_run_test(mailboxes_grow_and_shrink);
+    mu_run_test(producers_spray_many_actors);
+    return 0;
+}
@@ -0,0 +1,173 @@
+#include "fixture.h"
+
+#include <stdlib.h>
+
+#define MSG_PING 1
+#define MSG_DONE 2
+#define MESSAGES_TYPES 3
+
+#define CHILDREN 16
+#define PINGS 1000
+
+static size_t nnodes;
+static _Atomic long root_node = -2;
+static _Atomic size_t children_done;
+static _Atomic size_t pings;
+static _Atomic size_t pings_at_home;
+static _Atomic size_t misplaced;
+
+static role_t role_child;
+
+typedef struct child {
+    actor_id_t parent;
+    size_t pings;
+} child_t;
+
+/* Every handler runs on a worker of one of the nodes, and every actor has
+ * a home among them. */
+static void check_placement()
+{
+    long node = actor_node(actor_id_self());
+    long node_self = actor_system_node_self();
+    if (node < 0 || node >= (long) nnodes
+        || node_self < 0 || node_self >= (long) nnodes) {
+        atomic_fetch_add(&misplaced, 1);
+    }
+}
+
+static void on_hello_root(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    atomic_store(&root_node, actor_node(actor_id_self()));
+    check_placement();
+
+    for (size_t i = 0; i < CHILDREN; i++) {
+        spawn_child(&role_child);
+    }
+}
+
+static void on_done(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    check_placement();
+    if (atomic_fetch_add(&children_done, 1) + 1 == CHILDREN) {
+        die_self();
+    }
+}
+
+static void on_hello_child(void **stateptr, size_t nbytes, void *data)
+{
+    (void) nbytes;
+
+    child_t *child = malloc(sizeof(child_t));
+    if (child == NULL) {
+        exit(EXIT_FAILURE);
+    }
+    child->parent = (actor_id_t) data;
+    child->pings = 0;
+    *stateptr = child;
+    check_placement();
+
+    message_t ping = {.message_type = MSG_PING};
+    send_message(actor_id_self(), ping);
+}
+
+static void on_ping(void **stateptr, size_t nbytes, void *data)
+{
+    (void) nbytes;
+    (void) data;
+
+    check_placement();
+    if (actor_system_node_self() == actor_node(actor_id_self())) {
+        atomic_fetch_add(&pings_at_home, 1);
+    }
+
+    atomic_fetch_add(&pings, 1);
+
+    child_t *child = *stateptr;
+    if (++child->pings < PINGS) {
+        message_t ping = {.message_type = MSG_PING};
+        send_message(actor_id_self(), ping);
+        return;
+    }
+
+    message_t done = {.message_type = MSG_DONE};
+    send_message(child->parent, done);
+    free(child);
+    *stateptr = NULL;
+    die_self();
+}
+
+static act_t acts_root[] = {on_hello_root, NULL, on_done};
+static role_t role_root = {.nprompts = MESSAGES_TYPES, .prompts = acts_root};
+
+static act_t acts_child[] = {on_hello_child, on_ping, NULL};
+static role_t role_child = {.nprompts = MESSAGES_TYPES, .prompts = acts_child};
+
+static char *run_workload(const actor_system_config_t *config)
+{
+    atomic_store(&root_node, -2);
+    atomic_store(&children_done, 0);
+    atomic_store(&pings, 0);
+    atomic_store(&pings_at_home, 0);
+    atomic_store(&misplaced, 0);
+
+    actor_system_t *system;
+    actor_id_t root;
+    mu_assert("actor system start failed",
+              actor_system_start(&system, &root, &role_root, config) == 0);
+    actor_system_wait(system, root);
+
+    mu_assert("root spawned from outside was not placed on the first node",
+              atomic_load(&root_node) == 0);
+    mu_assert("an actor or a worker has no node", atomic_load(&misplaced) == 0);
+    mu_assert("not every child finished", atomic_load(&children_done) == CHILDREN);
+    mu_assert("pings were lost", atomic_load(&pings) == CHILDREN * PINGS);
+
+    printf(__FILE__ ": nodes=%zu pings handled at home %zu/%zu\n", nnodes,
+           atomic_load(&pings_at_home), atomic_load(&pings));
+    return 0;
+}
+
+static char *simulated_nodes()
+{
+    actor_system_config_t config;
+    actor_system_config_default(&config);
+    config.workers = 4;
+    config.numa = true;
+    config.numa_topology = "0;0";
+    nnodes = 2;
+
+    mu_assert("the main thread has a node", actor_system_node_self() == -1);
+    return run_workload(&config);
+}
+
+static char *single_node()
+{
+    actor_system_config_t config;
+    actor_system_config_default(&config);
+    config.workers = 2;
+    config.numa = false;
+    nnodes = 1;
+
+    char *result = run_workload(&config);
+    if (result != 0) {
+        return result;
+    }
+    mu_assert("a single node ran pings elsewhere",
+              atomic_load(&pings_at_home) == CHILDREN * PINGS);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(simulated_nodes);
+    mu_run_test(single_node);
+    return 0;
+}
@@ -0,0 +1,209 @@
+#include "fixture.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#define MSG_OWNED 1
+#define MSG_INLINE 2
+#define MSG_SHARED 3
+#define MESSAGES_TYPES 4
+
+#define MISSING_ACTOR 1000
+#define SHARED_BYTES 200
+#define SHARERS 4
+
+#define TEXT "owned by the message"
+
+static _Atomic size_t released;
+static _Atomic long released_in_handler = -1;
+static _Atomic bool owned_intact;
+static _Atomic bool inline_intact;
+static _Atomic bool inline_copied;
+static _Atomic size_t shared_intact;
+static unsigned char inline_source[MESSAGE_INLINE_BYTES];
+
+static void release_counted(void *data)
+{
+    (void) data;
+
+    atomic_fetch_add(&released, 1);
+}
+
+static void on_hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+}
+
+/* The message still owns its data while the handler runs. */
+static void on_owned(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+
+    atomic_store(&released_in_handler, (long) atomic_load(&released));
+    atomic_store(&owned_intact, nbytes == sizeof(TEXT) && strcmp(data, TEXT) == 0);
+}
+
+static void on_inline(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+
+    unsigned char *bytes = data;
+    bool intact = nbytes == MESSAGE_INLINE_BYTES;
+    for (size_t i = 0; intact && i < nbytes; i++) {
+        intact = bytes[i] == (unsigned char) i;
+    }
+    atomic_store(&inline_intact, intact);
+    atomic_store(&inline_copied, data != (void *) inline_source);
+}
+
+static void on_shared(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+
+    unsigned char *bytes = data;
+    bool intact = nbytes == SHARED_BYTES;
+    for (size_t i = 0; intact && i < nbytes; i++) {
+        intact = bytes[i] == (unsigned char) (i * 7);
+    }
+    if (intact) {
+        atomic_fetch_add(&shared_intact, 1);
+    }
+}
+
+static act_t acts[] = {on_hello, on_owned, on_inline, on_shared};
+static role_t role = {.nprompts = MESSAGES_TYPES, .prompts = acts};
+
+static char *messages_are_released_once()
+{
+    actor_id_t actor;
+    mu_assert("actor system create failed", actor_system_create(&actor, &role) == 0);
+
+    message_t refused = {.message_type = MSG_OWNED, .release = release_counted};
+    mu_assert("sent to a missing actor", send_message(MISSING_ACTOR, refused) == -2);
+    mu_assert("refused message was not released", atomic_load(&released) == 1);
+
+    char *text = message_payload_alloc(sizeof(TEXT));
+    strcpy(text, TEXT);
+    message_t owned = {
+            .message_type = MSG_OWNED,
+            .nbytes = sizeof(TEXT),
+            .data = text,
+            .release = release_counted
+    };
+    mu_assert("sending failed", send_message(actor, owned) == 0);
+
+    send_go_die(actor);
+    actor_system_join(actor);
+
+    mu_assert("data was released before the handler", atomic_load(&released_in_handler) == 1);
+    mu_assert("data did not reach the handler", atomic_load(&owned_intact));
+    mu_assert("handled message was not released", atomic_load(&released) == 2);
+    message_payload_release(text);
+    return 0;
+}
+
+static char *inline_payloads_are_copied()
+{
+    actor_id_t actor;
+    mu_assert("actor system create failed", actor_system_create(&actor, &role) == 0);
+
+    for (size_t i = 0; i < MESSAGE_INLINE_BYTES; i++) {
+        inline_source[i] = (unsigned char) i;
+    }
+    message_t too_big;
+    mu_assert("payload larger than MESSAGE_INLINE_BYTES was inlined",
+              message_inline(&too_big, MSG_INLINE, inline_source,
+                             MESSAGE_INLINE_BYTES + 1) != 0);
+
+    message_t message;
+    mu_assert("inlining failed",
+              message_inline(&message, MSG_INLINE, inline_source,
+                             MESSAGE_INLINE_BYTES) == 0);
+    memset(inline_source, 0xff, sizeof(inline_source));
+    send_message(actor, message);
+
+    send_go_die(actor);
+    actor_system_join(actor);
+
+    mu_assert("inline payload was not copied into the message", atomic_load(&inline_intact));
+    mu_assert("handler got the buffer of the sender", atomic_load(&inline_copied));
+    return 0;
+}
+
+/* A payload with a reference per message outlives all of them, and its
+ * block is reused once the last one is gone. */
+static char *shared_payloads_are_counted()
+{
+    actor_id_t actor;
+    mu_assert("actor system create failed", actor_system_create(&actor, &role) == 0);
+
+    unsigned char *shared = message_payload_alloc(SHARED_BYTES);
+    for (size_t i = 0; i < SHARED_BYTES; i++) {
+        shared[i] = (unsigned char) (i * 7);
+    }
+    for (size_t i = 1; i < SHARERS; i++) {
+        message_payload_retain(shared);
+    }
+    for (size_t i = 0; i < SHARERS; i++) {
+        message_t message = {
+                .message_type = MSG_SHARED,
+                .nbytes = SHARED_BYTES,
+                .data = shared,
+                .release = message_payload_release
+        };
+        send_message(actor, message);
+    }
+
+    send_go_die(actor);
+    actor_system_join(actor);
+
+    mu_assert("payload changed before every reader was done",
+              atomic_load(&shared_intact) == SHARERS);
+
+    void *first = message_payload_alloc(SHARED_BYTES);
+    message_payload_release(first);
+    void *second = message_payload_alloc(SHARED_BYTES);
+    mu_assert("freed payload was not reused", second == first);
+    message_payload_release(second);
+
+    void *huge = message_payload_alloc(1 << 20);
+    memset(huge, 0, 1 << 20);
+    message_payload_release(huge);
+    return 0;
+}
+
+static void *alloc_and_release(void *arg)
+{
+    void **payload = arg;
+    *payload = message_payload_alloc(SHARED_BYTES);
+    message_payload_release(*payload);
+
+    return NULL;
+}
+
+/* Threads outside the runtime keep no payloads to themselves, so those of
+ * a thread that has exited are still reused. */
+static char *payloads_outlive_their_threads()
+{
+    void *released;
+    pthread_t thread;
+    mu_assert("thread did not start",
+              pthread_create(&thread, NULL, alloc_and_release, &released) == 0);
+    pthread_join(thread, NULL);
+
+    void *payload = message_payload_alloc(SHARED_BYTES);
+    mu_assert("payload of an exited thread was not reused", payload == released);
+    message_payload_release(payload);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(messages_are_released_once);
+    mu_run_test(inline_payloads_are_copied);
+    mu_run_test(shared_payloads_are_counted);
+    mu_run_test(payloads_outlive_their_threads);
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include "fixture.h"
+
+#define MSG_SLOW 1
+#define MSG_URGENT 2
+#define MESSAGES_TYPES 3
+
+#define BACKLOG 100
+#define SLOW_MSEC 1
+
+/* Messages that may complete between reading the count and the urgent
+ * message being taken: the one in progress and the one just started. */
+#define BOUND 2
+
+static _Atomic size_t slow_handled;
+static _Atomic long urgent_seen = -1;
+static _Atomic long spawn_seen = -1;
+
+static void on_hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+}
+
+static void on_slow(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    sleep_msec(SLOW_MSEC);
+    atomic_fetch_add(&slow_handled, 1);
+}
+
+static void on_urgent(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    atomic_store(&urgent_seen, (long) atomic_load(&slow_handled));
+}
+
+static void on_hello_child(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    atomic_store(&spawn_seen, (long) atomic_load(&slow_handled));
+    die_self();
+}
+
+static act_t acts[] = {on_hello, on_slow, on_urgent};
+static role_t role = {.nprompts = MESSAGES_TYPES, .prompts = acts};
+
+static act_t acts_child[] = {on_hello_child};
+static role_t role_child = {.nprompts = 1, .prompts = acts_child};
+
+static void send_backlog(actor_id_t actor)
+{
+    message_t slow = {.message_type = MSG_SLOW};
+    for (size_t i = 0; i < BACKLOG; i++) {
+        send_message(actor, slow);
+    }
+}
+
+static char *urgent_and_spawn_skip_backlog()
+{
+    actor_id_t root;
+    mu_assert("actor system creation failed",
+              actor_system_create(&root, &role) == 0);
+
+    send_backlog(root);
+    long before_urgent = (long) atomic_load(&slow_handled);
+    message_t urgent = {.message_type = MSG_URGENT, .flags = MSG_FLAG_URGENT};
+    mu_assert("sending an urgent message failed", send_message(root, urgent) == 0);
+
+    send_backlog(root);
+    long before_spawn = (long) atomic_load(&slow_handled);
+    message_t spawn = {
+            .message_type = MSG_SPAWN,
+            .nbytes = sizeof(role_t),
+            .data = &role_child
+    };
+    mu_assert("sending spawn failed", send_message(root, spawn) == 0);
+
+    message_t go_die = {.message_type = MSG_GODIE};
+    mu_assert("sending godie failed", send_message(root, go_die) == 0);
+    actor_system_join(root);
+
+    mu_assert("backlog was not handled after godie",
+              atomic_load(&slow_handled) == 2 * BACKLOG);
+    mu_assert("urgent message was not handled", atomic_load(&urgent_seen) >= 0);
+    mu_assert("urgent message waited behind the backlog",
+              atomic_load(&urgent_seen) <= before_urgent + BOUND);
+    mu_assert("spawned actor was not greeted", atomic_load(&spawn_seen) >= 0);
+    mu_assert("spawn waited behind the backlog",
+              atomic_load(&spawn_seen) <= before_spawn + BOUND + 1);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(urgent_and_spawn_skip_backlog);
+    return 0;
+}
@@ -0,0 +1,340 @@
+#include "fixture.h"
+
+#include <stdint.h>
+#include <inttypes.h>
+
+#define MSG_PING 1
+#define MSG_TICK 2
+#define MESSAGES_TYPES 3
+
+#define ROUNDS 20000
+#define BURST (3 * ACTOR_QUEUE_LIMIT)
+#define SPIN_NSEC 500000000L
+#define WAKE_BOUND_NSEC 100000000L
+
+static role_t role_pinger;
+static role_t role_ticker;
+static role_t role_sink;
+static role_t role_sleeper;
+static role_t role_idler;
+
+static actor_id_t pinger = -1;
+static actor_id_t ticker = -1;
+static _Atomic actor_id_t idler = -1;
+static size_t rounds;
+static _Atomic size_t ticks;
+static _Atomic size_t ticks_halfway;
+static _Atomic size_t ticks_at_end;
+static _Atomic size_t received;
+static _Atomic uint64_t woken_at;
+static _Atomic uint64_t started_at;
+static uint64_t spun_until;
+
+static uint64_t now_nsec(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+}
+
+static void on_hello_root(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    spawn_child(&role_ticker);
+    spawn_child(&role_pinger);
+}
+
+/* Every ping wakes up the other side of the pair, which would run next
+ * forever if the ticker waiting in the run queue did not take precedence.
+ * The pair starts once both the pinger and the ticker have registered. */
+static void ping_pong(void)
+{
+    if (pinger < 0 || ticker < 0) {
+        return;
+    }
+
+    rounds++;
+    if (rounds == ROUNDS / 2) {
+        atomic_store(&ticks_halfway, atomic_load(&ticks));
+    }
+    if (rounds < ROUNDS) {
+        message_t ping = {.message_type = MSG_PING};
+        send_message(pinger, ping);
+        return;
+    }
+
+    atomic_store(&ticks_at_end, atomic_load(&ticks));
+    send_go_die(pinger);
+    send_go_die(ticker);
+    die_self();
+}
+
+static void on_ping_root(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+
+    if (data != NULL) {
+        pinger = (actor_id_t) data;
+    }
+    ping_pong();
+}
+
+static void on_tick_root(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+
+    ticker = (actor_id_t) data;
+    ping_pong();
+}
+
+static void on_hello_pinger(void **stateptr, size_t nbytes, void *data)
+{
+    (void) nbytes;
+
+    *stateptr = data;
+    message_t ping = {
+            .message_type = MSG_PING,
+            .nbytes = sizeof(actor_id_t),
+            .data = (void *) actor_id_self()
+    };
+    send_message((actor_id_t) data, ping);
+}
+
+static void on_ping_pinger(void **stateptr, size_t nbytes, void *data)
+{
+    (void) nbytes;
+    (void) data;
+
+    message_t ping = {.message_type = MSG_PING};
+    send_message((actor_id_t) *stateptr, ping);
+}
+
+/* Keeps itself busy, going back to the run queue after every activation. */
+static void on_hello_ticker(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+
+    message_t registration = {
+            .message_type = MSG_TICK,
+            .nbytes = sizeof(actor_id_t),
+            .data = (void *) actor_id_self()
+    };
+    send_message((actor_id_t) data, registration);
+
+    message_t tick = {.message_type = MSG_TICK};
+    send_message(actor_id_self(), tick);
+}
+
+static void on_tick(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    atomic_fetch_add(&ticks, 1);
+    message_t tick = {.message_type = MSG_TICK};
+    send_message(actor_id_self(), tick);
+}
+
+static act_t acts_root[] = {on_hello_root, on_ping_root, on_tick_root};
+static role_t role_root = {.nprompts = MESSAGES_TYPES, .prompts = acts_root};
+
+static act_t acts_pinger[] = {on_hello_pinger, on_ping_pinger, NULL};
+static role_t role_pinger = {.nprompts = MESSAGES_TYPES, .prompts = acts_pinger};
+
+static act_t acts_ticker[] = {on_hello_ticker, NULL, on_tick};
+static role_t role_ticker = {.nprompts = MESSAGES_TYPES, .prompts = acts_ticker};
+
+static char *ping_pong_does_not_starve_others()
+{
+    mu_assert("actor system create failed",
+              run_system_with_workers(&role_root, 1) == 0);
+
+    mu_assert("ping-pong did not finish", rounds == ROUNDS);
+    mu_assert("ticker starved during ping-pong",
+              atomic_load(&ticks_at_end) > atomic_load(&ticks_halfway));
+    return 0;
+}
+
+static void on_hello_burst(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    spawn_child(&role_sink);
+}
+
+/* The sink runs next once woken up, so it has to be given away when the
+ * burst blocks on its full mailbox. */
+static void on_ping_burst(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+
+    actor_id_t sink = (actor_id_t) data;
+    message_t ping = {.message_type = MSG_PING};
+    for (size_t i = 0; i < BURST; i++) {
+        send_message(sink, ping);
+    }
+
+    send_go_die(sink);
+    die_self();
+}
+
+static void on_hello_sink(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+
+    message_t ping = {
+            .message_type = MSG_PING,
+            .nbytes = sizeof(actor_id_t),
+            .data = (void *) actor_id_self()
+    };
+    send_message((actor_id_t) data, ping);
+}
+
+static void on_ping_sink(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    atomic_fetch_add(&received, 1);
+}
+
+static act_t acts_burst[] = {on_hello_burst, on_ping_burst, NULL};
+static role_t role_burst = {.nprompts = MESSAGES_TYPES, .prompts = acts_burst};
+
+static act_t acts_sink[] = {on_hello_sink, on_ping_sink, NULL};
+static role_t role_sink = {.nprompts = MESSAGES_TYPES, .prompts = acts_sink};
+
+static char *blocked_sender_gives_away_next()
+{
+    mu_assert("actor system create failed",
+              run_system_with_workers(&role_burst, 2) == 0);
+
+    mu_assert("burst was not received", atomic_load(&received) == BURST);
+    return 0;
+}
+
+static void on_hello_waker(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    spawn_child(&role_sleeper);
+    spawn_child(&role_idler);
+}
+
+/* Wakes up the sleeper, which waits in run_next, and keeps the worker busy
+ * for far longer than any grace period. */
+static void on_ping_waker(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+
+    actor_id_t sleeper = (actor_id_t) data;
+    message_t tick = {.message_type = MSG_TICK};
+    atomic_store(&woken_at, now_nsec());
+    send_message(sleeper, tick);
+
+    uint64_t until = now_nsec() + SPIN_NSEC;
+    while (now_nsec() < until) {
+    }
+    spun_until = until;
+
+    send_go_die(sleeper);
+    send_go_die(atomic_load(&idler));
+    die_self();
+}
+
+static void on_hello_sleeper(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+
+    message_t ping = {
+            .message_type = MSG_PING,
+            .nbytes = sizeof(actor_id_t),
+            .data = (void *) actor_id_self()
+    };
+    send_message((actor_id_t) data, ping);
+}
+
+static void on_tick_sleeper(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    atomic_store(&started_at, now_nsec());
+}
+
+static void on_hello_idler(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    atomic_store(&idler, actor_id_self());
+}
+
+static void on_ping_idler(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+}
+
+static act_t acts_waker[] = {on_hello_waker, on_ping_waker, NULL};
+static role_t role_waker = {.nprompts = MESSAGES_TYPES, .prompts = acts_waker};
+
+static act_t acts_sleeper[] = {on_hello_sleeper, NULL, on_tick_sleeper};
+static role_t role_sleeper = {.nprompts = MESSAGES_TYPES, .prompts = acts_sleeper};
+
+static act_t acts_idler[] = {on_hello_idler, on_ping_idler, NULL};
+static role_t role_idler = {.nprompts = MESSAGES_TYPES, .prompts = acts_idler};
+
+/* The idler is pinged from outside meanwhile, so that the other workers
+ * keep looking for work. */
+static char *long_handler_does_not_hold_next()
+{
+    actor_id_t waker;
+    mu_assert("actor system create failed",
+              create_system_with_workers(&waker, &role_waker, 4) == 0);
+
+    message_t ping = {.message_type = MSG_PING};
+    for (size_t round = 0; round < WAIT_ROUNDS && atomic_load(&started_at) == 0;
+         round++) {
+        if (atomic_load(&idler) >= 0) {
+            send_message(atomic_load(&idler), ping);
+        }
+        sleep_msec(1);
+    }
+    actor_system_join(waker);
+
+    mu_assert("waker did not spin", spun_until > 0);
+    mu_assert("sleeper was never woken up", atomic_load(&started_at) > 0);
+    uint64_t latency = atomic_load(&started_at) - atomic_load(&woken_at);
+    printf(__FILE__ ": woken actor started after %" PRIu64 " ns\n", latency);
+    mu_assert("woken actor waited for the long handler",
+              latency < WAKE_BOUND_NSEC);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(ping_pong_does_not_starve_others);
+    mu_run_test(blocked_sender_gives_away_next);
+    mu_run_test(long_handler_does_not_hold_next);
+    return 0;
+}
@@ -0,0 +1,273 @@
+#include "fixture.h"
+
+#define MSG_WORK 1
+#define MSG_PING 2
+#define MSG_WAKE 3
+#define MESSAGES_TYPES 4
+
+#define HOGS 4
+#define HOG_BURST 256
+#define BUSY_WORK 10000
+#define OUTSIDERS 500
+#define WAKEUPS 20
+#define IDLE_MSEC 5
+#define SLEEPERS 3
+#define SLEEP_MSEC 100
+
+static _Atomic bool stop;
+static _Atomic size_t worked;
+static _Atomic size_t pinged;
+static size_t worked_when_pinged;
+
+static actor_id_t outsiders[OUTSIDERS];
+static _Atomic size_t outsiders_spawned;
+static _Atomic size_t outsiders_known;
+static _Atomic size_t outsiders_pinged;
+
+static actor_id_t sleepers[SLEEPERS];
+static _Atomic size_t sleepers_spawned;
+static _Atomic size_t sleepers_known;
+static _Atomic size_t slept;
+static _Atomic size_t woken;
+
+static role_t role_hog;
+static role_t role_outsider;
+static role_t role_sleeper;
+
+static void on_hello_root(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    for (size_t i = 0; i < HOGS; i++) {
+        spawn_child(&role_hog);
+    }
+}
+
+static void on_ping_root(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    worked_when_pinged = atomic_load(&worked);
+    atomic_store(&stop, true);
+    atomic_fetch_add(&pinged, 1);
+    die_self();
+}
+
+/* Keeps its mailbox from ever running dry until told to stop. */
+static void on_hello_hog(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    message_t work = {.message_type = MSG_WORK};
+    for (size_t i = 0; i < HOG_BURST; i++) {
+        send_message(actor_id_self(), work);
+    }
+}
+
+static void on_work(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    atomic_fetch_add(&worked, 1);
+    if (atomic_load(&stop)) {
+        die_self();
+    }
+    else {
+        message_t work = {.message_type = MSG_WORK};
+        send_message(actor_id_self(), work);
+    }
+}
+
+static void on_hello_spawner(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    for (size_t i = 0; i < OUTSIDERS; i++) {
+        spawn_child(&role_outsider);
+    }
+    die_self();
+}
+
+static void on_hello_outsider(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    outsiders[atomic_fetch_add(&outsiders_spawned, 1)] = actor_id_self();
+    atomic_fetch_add(&outsiders_known, 1);
+}
+
+static void on_ping_outsider(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    atomic_fetch_add(&outsiders_pinged, 1);
+    die_self();
+}
+
+static void on_hello_sleepers(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    for (size_t i = 0; i < SLEEPERS; i++) {
+        spawn_child(&role_sleeper);
+    }
+}
+
+static void on_wake(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    atomic_fetch_add(&woken, 1);
+}
+
+static void on_hello_sleeper(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    sleepers[atomic_fetch_add(&sleepers_spawned, 1)] = actor_id_self();
+    atomic_fetch_add(&sleepers_known, 1);
+}
+
+static void on_ping_sleeper(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    sleep_msec(SLEEP_MSEC);
+    atomic_fetch_add(&slept, 1);
+    die_self();
+}
+
+static act_t acts_root[] = {on_hello_root, NULL, on_ping_root, NULL};
+static role_t role_root = {.nprompts = MESSAGES_TYPES, .prompts = acts_root};
+
+static act_t acts_hog[] = {on_hello_hog, on_work, NULL, NULL};
+static role_t role_hog = {.nprompts = MESSAGES_TYPES, .prompts = acts_hog};
+
+static act_t acts_spawner[] = {on_hello_spawner, NULL, NULL, NULL};
+static role_t role_spawner = {.nprompts = MESSAGES_TYPES, .prompts = acts_spawner};
+
+static act_t acts_outsider[] = {on_hello_outsider, NULL, on_ping_outsider, NULL};
+static role_t role_outsider = {.nprompts = MESSAGES_TYPES, .prompts = acts_outsider};
+
+static act_t acts_sleepers[] = {on_hello_sleepers, NULL, NULL, on_wake};
+static role_t role_sleepers = {.nprompts = MESSAGES_TYPES, .prompts = acts_sleepers};
+
+static act_t acts_sleeper[] = {on_hello_sleeper, NULL, on_ping_sleeper, NULL};
+static role_t role_sleeper = {.nprompts = MESSAGES_TYPES, .prompts = acts_sleeper};
+
+/* Actors that always have messages left do not keep an idle one from
+ * being run. */
+static char *busy_actors_leave_room_for_others()
+{
+    actor_id_t root;
+    mu_assert("actor system create failed", actor_system_create(&root, &role_root) == 0);
+    mu_assert("hogs did not start", wait_for(&worked, BUSY_WORK));
+
+    message_t ping = {.message_type = MSG_PING};
+    send_message(root, ping);
+    bool handled = wait_for(&pinged, 1);
+    atomic_store(&stop, true);
+    actor_system_join(root);
+
+    mu_assert("idle actor starved behind busy ones", handled);
+    mu_assert("busy actors did not run", worked_when_pinged >= BUSY_WORK);
+    return 0;
+}
+
+/* Every actor woken by a thread outside the system is run, and the
+ * workers stop once the last one dies. */
+static char *actors_scheduled_from_outside_run()
+{
+    actor_id_t spawner;
+    mu_assert("actor system create failed",
+              actor_system_create(&spawner, &role_spawner) == 0);
+    mu_assert("actors were not spawned", wait_for(&outsiders_known, OUTSIDERS));
+
+    message_t ping = {.message_type = MSG_PING};
+    for (size_t i = 0; i < OUTSIDERS; i++) {
+        mu_assert("sending failed", send_message(outsiders[i], ping) == 0);
+    }
+    actor_system_join(spawner);
+
+    mu_assert("not every actor was run", atomic_load(&outsiders_pinged) == OUTSIDERS);
+    return 0;
+}
+
+static long msec_since(const struct timespec *then)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec - then->tv_sec) * 1000 + (now.tv_nsec - then->tv_nsec) / 1000000;
+}
+
+/* Workers parked while the system was idle are woken, as many as there
+ * are actors to run. */
+static char *parked_workers_wake_up()
+{
+    actor_id_t root;
+    mu_assert("actor system create failed",
+              create_system_with_workers(&root, &role_sleepers, SLEEPERS) == 0);
+    mu_assert("sleepers were not spawned", wait_for(&sleepers_known, SLEEPERS));
+
+    message_t wake = {.message_type = MSG_WAKE};
+    long slowest = 0;
+    for (size_t i = 0; i < WAKEUPS; i++) {
+        sleep_msec(IDLE_MSEC);
+        struct timespec sent;
+        clock_gettime(CLOCK_MONOTONIC, &sent);
+        mu_assert("sending failed", send_message(root, wake) == 0);
+        mu_assert("parked workers missed a message", wait_for(&woken, i + 1));
+        if (msec_since(&sent) > slowest) {
+            slowest = msec_since(&sent);
+        }
+    }
+
+    sleep_msec(IDLE_MSEC);
+    message_t ping = {.message_type = MSG_PING};
+    struct timespec started;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+    for (size_t i = 0; i < SLEEPERS; i++) {
+        mu_assert("sending failed", send_message(sleepers[i], ping) == 0);
+    }
+    mu_assert("sleepers were not woken", wait_for(&slept, SLEEPERS));
+    long elapsed = msec_since(&started);
+
+    send_go_die(root);
+    actor_system_join(root);
+
+    printf(__FILE__ ": slowest wakeup %ld ms, %d sleepers took %ld ms\n",
+           slowest, SLEEPERS, elapsed);
+    mu_assert("sleepers did not run side by side", elapsed < (SLEEPERS + 1) * SLEEP_MSEC / 2);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(busy_actors_leave_room_for_others);
+    mu_run_test(actors_scheduled_from_outside_run);
+    mu_run_test(parked_workers_wake_up);
+    return 0;
+}
@@ -0,0 +1,195 @@
+#include "fixture.h"
+
+#define MSG_DONE 1
+#define MSG_AFTER 2
+#define MESSAGES_TYPES 3
+
+#define CHILDREN 300
+#define BIG_BYTES (4 * MESSAGE_INLINE_BYTES)
+
+static role_t role_big;
+static role_t role_small;
+
+static actor_id_t root = -1;
+static actor_id_t big = -1;
+static actor_id_t children[CHILDREN];
+static size_t spawned_many;
+static size_t done;
+static _Atomic size_t wrong_data;
+static _Atomic size_t wrong_id;
+static _Atomic size_t afters;
+
+typedef struct small_init {
+    actor_id_t parent;
+    size_t index;
+} small_init_t;
+
+static void report_done(actor_id_t parent)
+{
+    message_t done = {.message_type = MSG_DONE};
+    send_message(parent, done);
+    die_self();
+}
+
+/* Every child greets the root once, so the root dies after all of them. */
+static void on_done(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    if (++done == CHILDREN + 1) {
+        die_self();
+    }
+}
+
+static void on_hello_root(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    root = actor_id_self();
+
+    unsigned char init[BIG_BYTES];
+    for (size_t i = 0; i < BIG_BYTES; i++) {
+        init[i] = (unsigned char) i;
+    }
+    big = actor_spawn(&role_big, sizeof(init), init);
+
+    small_init_t inits[CHILDREN];
+    for (size_t i = 0; i < CHILDREN; i++) {
+        inits[i] = (small_init_t) {.parent = root, .index = i};
+    }
+    spawned_many = actor_spawn_many(&role_small, CHILDREN, children,
+                                    sizeof(small_init_t), inits);
+}
+
+/* Does not fit inline, so it comes in a payload. */
+static void on_hello_big(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+
+    unsigned char *init = data;
+    bool correct = nbytes == BIG_BYTES;
+    for (size_t i = 0; correct && i < BIG_BYTES; i++) {
+        correct = init[i] == (unsigned char) i;
+    }
+    if (!correct) {
+        atomic_fetch_add(&wrong_data, 1);
+    }
+
+    report_done(root);
+}
+
+static void on_hello_small(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+
+    small_init_t *init = data;
+    if (nbytes != sizeof(small_init_t) || init->parent != root) {
+        atomic_fetch_add(&wrong_data, 1);
+        return;
+    }
+
+    if (children[init->index] != actor_id_self()) {
+        atomic_fetch_add(&wrong_id, 1);
+    }
+    report_done(init->parent);
+}
+
+static act_t acts_root[] = {on_hello_root, on_done, NULL};
+static role_t role_root = {.nprompts = MESSAGES_TYPES, .prompts = acts_root};
+
+static act_t acts_big[] = {on_hello_big, NULL, NULL};
+static role_t role_big = {.nprompts = MESSAGES_TYPES, .prompts = acts_big};
+
+static act_t acts_small[] = {on_hello_small, NULL, NULL};
+static role_t role_small = {.nprompts = MESSAGES_TYPES, .prompts = acts_small};
+
+static char *spawned_actors_get_their_init_data()
+{
+    mu_assert("actor system create failed",
+              run_system_with_workers(&role_root, 3) == 0);
+
+    mu_assert("direct spawn failed", big >= 0);
+    mu_assert("not every actor was spawned", spawned_many == CHILDREN);
+    mu_assert("not every actor finished", done == CHILDREN + 1);
+    mu_assert("init data was not delivered", atomic_load(&wrong_data) == 0);
+    mu_assert("returned ids do not match the actors", atomic_load(&wrong_id) == 0);
+    return 0;
+}
+
+static void on_hello_quit(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    die_self();
+}
+
+static act_t acts_quit[] = {on_hello_quit, NULL, NULL};
+static role_t role_quit = {.nprompts = MESSAGES_TYPES, .prompts = acts_quit};
+
+/* The default system is gone once joined, along with its actor table. */
+static char *spawning_after_join_fails()
+{
+    mu_assert("actor system create failed", run_system(&role_quit) == 0);
+
+    actor_id_t actors[2];
+    mu_assert("spawned into a joined system",
+              actor_spawn(&role_quit, 0, NULL) == -1);
+    mu_assert("spawned many into a joined system",
+              actor_spawn_many(&role_quit, 2, actors, 0, NULL) == 0);
+    return 0;
+}
+
+static void on_after(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    atomic_fetch_add(&afters, 1);
+    die_self();
+}
+
+static act_t acts_silent[] = {NULL, NULL, on_after};
+static role_t role_silent = {.nprompts = MESSAGES_TYPES, .prompts = acts_silent};
+
+/* Sends messages without a handler, to itself and to an actor without a
+ * hello handler, each followed by one that has a handler. */
+static void on_hello_skipping(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    actor_id_t silent = actor_spawn(&role_silent, 0, NULL);
+    message_t skipped = {.message_type = MSG_DONE};
+    message_t after = {.message_type = MSG_AFTER};
+    send_message(silent, skipped);
+    send_message(silent, after);
+    send_message(actor_id_self(), skipped);
+    send_message(actor_id_self(), after);
+}
+
+static act_t acts_skipping[] = {on_hello_skipping, NULL, on_after};
+static role_t role_skipping = {.nprompts = MESSAGES_TYPES, .prompts = acts_skipping};
+
+static char *missing_handlers_are_skipped()
+{
+    mu_assert("actor system create failed", run_system(&role_skipping) == 0);
+
+    mu_assert("messages after a missing handler were lost", atomic_load(&afters) == 2);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(spawned_actors_get_their_init_data);
+    mu_run_test(spawning_after_join_fails);
+    mu_run_test(missing_handlers_are_skipped);
+    return 0;
+}
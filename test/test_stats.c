@@ -0,0 +1,95 @@
+#include "fixture.h"
+
+#define MSG_SLOW 1
+#define MESSAGES_TYPES 2
+
+#define BACKLOG 20
+#define SLOW_NSEC 5000000L
+
+/* queue_wait samples the first position of every mailbox segment, and the
+ * first one holds at most four messages, so a sampled message waits behind
+ * at least four others. */
+#define SAMPLED_BEHIND 4
+
+static size_t handled;
+static int stats_err = -1;
+static int handler_err = -1;
+static actor_system_stats_t stats;
+static stats_histogram_t slow_time;
+
+static void on_hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+}
+
+static role_t role;
+
+/* The statistics are taken by the last message, once the backlog has been
+ * waiting behind the busy actor. */
+static void on_slow(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    sleep_msec(SLOW_NSEC / 1000000);
+
+    if (++handled < BACKLOG) {
+        return;
+    }
+
+    stats_err = actor_system_stats(&stats);
+    handler_err = actor_system_handler_stats(&role, MSG_SLOW, &slow_time);
+
+    die_self();
+}
+
+static act_t acts[] = {on_hello, on_slow};
+static role_t role = {.nprompts = MESSAGES_TYPES, .prompts = acts};
+
+static char *backlog_shows_in_queue_wait()
+{
+    actor_id_t actor;
+    mu_assert("actor system create failed", actor_system_create(&actor, &role) == 0);
+
+    message_t slow = {.message_type = MSG_SLOW};
+    for (size_t i = 0; i < BACKLOG; i++) {
+        send_message(actor, slow);
+    }
+    actor_system_join(actor);
+
+    mu_assert("stats failed", stats_err == 0);
+    mu_assert("handler stats failed", handler_err == 0);
+
+    /* The hello and every slow message but the one still running. */
+    mu_assert("handled messages were not counted",
+              stats.total.messages >= BACKLOG);
+    mu_assert("no dispatch was timed from its enqueue",
+              stats.total.queue_wait.count >= 2);
+    mu_assert("sampled messages did not wait for the backlog",
+              stats.total.queue_wait.max >= SAMPLED_BEHIND * SLOW_NSEC * 9 / 10);
+    mu_assert("the backlog showed up as scheduling delay",
+              stats.total.schedule_wait.max < SAMPLED_BEHIND * SLOW_NSEC / 2);
+    mu_assert("slow handlers were not timed",
+              slow_time.count == BACKLOG - 1 && slow_time.sum >= (BACKLOG - 1) * SLOW_NSEC);
+    mu_assert("busy time is missing", stats.total.busy_nsec >= (BACKLOG - 1) * SLOW_NSEC);
+
+    actor_system_stats_free(&stats);
+    return 0;
+}
+
+static char *no_stats_without_system()
+{
+    actor_system_stats_t none;
+    mu_assert("stats of a joined system", actor_system_stats(&none) == -1);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(backlog_shows_in_queue_wait);
+    mu_run_test(no_stats_without_system);
+    return 0;
+}
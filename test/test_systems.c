@@ -0,0 +1,173 @@
+#include "fixture.h"
+
+#include <stdint.h>
+
+#define MSG_PING 1
+#define MSG_TICK 2
+#define MESSAGES_TYPES 3
+
+#define SYSTEMS 2
+#define MAX_MEMBERS 5
+
+static const size_t nmembers[SYSTEMS] = {MAX_MEMBERS, 3};
+
+static actor_system_t *systems[SYSTEMS];
+static _Atomic size_t pinged[SYSTEMS];
+static _Atomic size_t ticked[SYSTEMS];
+static _Atomic size_t wrong_system;
+
+/* Set once actor_system_start has returned, before any message is sent
+ * from outside. */
+static size_t system_index(void)
+{
+    actor_system_t *self = actor_system_self();
+    for (size_t i = 0; i < SYSTEMS; i++) {
+        if (systems[i] == self) {
+            return i;
+        }
+    }
+
+    atomic_fetch_add(&wrong_system, 1);
+    return 0;
+}
+
+static void on_hello_root(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+}
+
+static void on_tick_root(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    atomic_fetch_add(&ticked[system_index()], 1);
+}
+
+/* Members learn the index of the system they were spawned into. */
+static void on_hello_member(void **stateptr, size_t nbytes, void *data)
+{
+    (void) nbytes;
+
+    *stateptr = (void *) (intptr_t) *(int *) data;
+}
+
+static void on_ping_member(void **stateptr, size_t nbytes, void *data)
+{
+    (void) nbytes;
+    (void) data;
+
+    size_t index = (size_t) (intptr_t) *stateptr;
+    if (system_index() != index) {
+        atomic_fetch_add(&wrong_system, 1);
+    }
+    atomic_fetch_add(&pinged[index], 1);
+}
+
+static act_t acts_root[] = {on_hello_root, NULL, on_tick_root};
+static role_t role_root = {.nprompts = MESSAGES_TYPES, .prompts = acts_root};
+
+static act_t acts_member[] = {on_hello_member, on_ping_member, NULL};
+static role_t role_member = {.nprompts = MESSAGES_TYPES, .prompts = acts_member};
+
+static bool wait_for_both(_Atomic size_t *counters, size_t expected_first,
+                          size_t expected_second)
+{
+    return wait_for(&counters[0], expected_first)
+           && wait_for(&counters[1], expected_second);
+}
+
+/* Both systems have a root with id 0, members with the same ids and a
+ * group with the same name, driven from the main thread through the
+ * variants taking the system. */
+static char *systems_stay_isolated()
+{
+    actor_system_config_t config;
+    actor_system_config_default(&config);
+    config.workers = 2;
+
+    actor_id_t roots[SYSTEMS];
+    for (size_t i = 0; i < SYSTEMS; i++) {
+        mu_assert("actor system start failed",
+                  actor_system_start(&systems[i], &roots[i], &role_root, &config) == 0);
+    }
+    mu_assert("roots of both systems should have the same id", roots[0] == roots[1]);
+
+    actor_id_t members[SYSTEMS][MAX_MEMBERS];
+    group_id_t groups[SYSTEMS];
+    for (size_t i = 0; i < SYSTEMS; i++) {
+        int inits[MAX_MEMBERS];
+        for (size_t j = 0; j < MAX_MEMBERS; j++) {
+            inits[j] = (int) i;
+        }
+        mu_assert("spawning members failed",
+                  actor_system_spawn_many(systems[i], &role_member, nmembers[i],
+                                          members[i], sizeof(int), inits) == nmembers[i]);
+
+        groups[i] = actor_system_group(systems[i], "members");
+        for (size_t j = 0; j < nmembers[i]; j++) {
+            mu_assert("joining the group failed",
+                      actor_system_group_join(systems[i], groups[i], members[i][j]) == 0);
+        }
+    }
+    mu_assert("groups of both systems should have the same id", groups[0] == groups[1]);
+
+    message_t ping = {.message_type = MSG_PING};
+    for (size_t i = 0; i < SYSTEMS; i++) {
+        mu_assert("broadcast reached members of the other system",
+                  actor_system_broadcast(systems[i], groups[i], ping) == (int) nmembers[i]);
+    }
+    mu_assert("pings were not handled", wait_for_both(pinged, nmembers[0], nmembers[1]));
+
+    /* The last member of the first system has no counterpart in the second. */
+    actor_id_t only_first = members[0][MAX_MEMBERS - 1];
+    mu_assert("sent to an actor of the other system",
+              actor_system_try_send(systems[1], only_first, ping) == -2);
+    mu_assert("sending failed", actor_system_try_send(systems[0], only_first, ping) == 0);
+
+    message_t pings[2] = {{.message_type = MSG_PING}, {.message_type = MSG_PING}};
+    mu_assert("sending many failed",
+              actor_system_send_messages(systems[1], members[1][0], pings, 2) == 2);
+    mu_assert("pings were not handled",
+              wait_for_both(pinged, nmembers[0] + 1, nmembers[1] + 2));
+
+    message_t tick = {.message_type = MSG_TICK};
+    mu_assert("timer failed",
+              actor_system_send_after(systems[0], roots[0], tick, 1) >= 0);
+    mu_assert("ticks were not handled", wait_for_both(ticked, 1, 0));
+
+    stats_histogram_t handled[SYSTEMS];
+    for (size_t i = 0; i < SYSTEMS; i++) {
+        mu_assert("handler stats failed",
+                  actor_system_handler_stats_of(systems[i], &role_member, MSG_PING,
+                                                &handled[i]) == 0);
+    }
+    mu_assert("stats of the systems were mixed up",
+              handled[0].count == nmembers[0] + 1 && handled[1].count == nmembers[1] + 2);
+
+    message_t go_die = {.message_type = MSG_GODIE};
+    for (size_t i = 0; i < SYSTEMS; i++) {
+        actor_system_broadcast(systems[i], groups[i], go_die);
+        actor_system_send(systems[i], roots[i], go_die);
+    }
+    for (size_t i = 0; i < SYSTEMS; i++) {
+        actor_system_wait(systems[i], roots[i]);
+    }
+
+    mu_assert("a handler ran in the wrong system", atomic_load(&wrong_system) == 0);
+    mu_assert("pings leaked between systems",
+              atomic_load(&pinged[0]) == nmembers[0] + 1
+              && atomic_load(&pinged[1]) == nmembers[1] + 2);
+    mu_assert("tick went to the wrong system",
+              atomic_load(&ticked[0]) == 1 && atomic_load(&ticked[1]) == 0);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(systems_stay_isolated);
+    return 0;
+}
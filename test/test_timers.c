@@ -0,0 +1,214 @@
+#include "fixture.h"
+
+#define MSG_TICK 1
+#define MSG_LATE 2
+#define MSG_STOP 3
+#define MSG_SLOW_TICK 4
+#define MESSAGES_TYPES 5
+
+#define TICKS 5
+#define PERIOD_MSEC 2
+#define LATE_MSEC 20
+#define LATER_MSEC 10000
+#define SLOW_TICKS 30
+#define SLOW_TICK_MSEC 10
+
+/* The tick being handled may be followed by one more, delivered once it is
+ * done, and by the late message. */
+#define BOUND 2
+
+static timer_id_t timer = -1;
+static size_t ticks;
+static int cancelled = -1;
+static struct timespec started;
+static long late_msec = -1;
+static size_t ticks_after_cancel;
+static _Atomic size_t released;
+static timer_id_t slow_timer = -1;
+static size_t slow_ticks;
+static _Atomic bool slow_late_seen;
+static unsigned long long high_water;
+static int stats_err = -1;
+
+static long msec_since(const struct timespec *then)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec - then->tv_sec) * 1000 + (now.tv_nsec - then->tv_nsec) / 1000000;
+}
+
+static void release_counted(void *data)
+{
+    (void) data;
+
+    atomic_fetch_add(&released, 1);
+}
+
+static void on_hello(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    clock_gettime(CLOCK_MONOTONIC, &started);
+
+    message_t late = {.message_type = MSG_LATE};
+    send_message_after(actor_id_self(), late, LATE_MSEC);
+
+    message_t tick = {.message_type = MSG_TICK};
+    timer = send_message_every(actor_id_self(), tick, PERIOD_MSEC);
+}
+
+/* Cancels its timer after TICKS, and stops well after the last one. */
+static void on_tick(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    if (++ticks == TICKS) {
+        cancelled = cancel_timer(timer);
+
+        message_t stop = {.message_type = MSG_STOP};
+        send_message_after(actor_id_self(), stop, 2 * LATE_MSEC);
+    }
+}
+
+static void on_late(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    late_msec = msec_since(&started);
+}
+
+static void on_stop(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    ticks_after_cancel = ticks - TICKS;
+    die_self();
+}
+
+static void on_hello_slow(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    message_t tick = {.message_type = MSG_SLOW_TICK};
+    slow_timer = send_message_every(actor_id_self(), tick, PERIOD_MSEC);
+
+    message_t late = {.message_type = MSG_LATE};
+    send_message_after(actor_id_self(), late, 5 * PERIOD_MSEC);
+}
+
+/* Takes several periods of the timer every time. */
+static void on_slow_tick(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    sleep_msec(SLOW_TICK_MSEC);
+    if (++slow_ticks < SLOW_TICKS) {
+        return;
+    }
+
+    cancel_timer(slow_timer);
+
+    actor_system_stats_t stats;
+    stats_err = actor_system_stats(&stats);
+    if (stats_err == 0) {
+        high_water = stats.total.mailbox_high_water;
+        actor_system_stats_free(&stats);
+    }
+    die_self();
+}
+
+static void on_slow_late(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    atomic_store(&slow_late_seen, true);
+}
+
+static void on_hello_quiet(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+}
+
+static act_t acts[] = {on_hello, on_tick, on_late, on_stop, NULL};
+static role_t role = {.nprompts = MESSAGES_TYPES, .prompts = acts};
+
+static act_t acts_slow[] = {on_hello_slow, NULL, on_slow_late, NULL, on_slow_tick};
+static role_t role_slow = {.nprompts = MESSAGES_TYPES, .prompts = acts_slow};
+
+static act_t acts_quiet[] = {on_hello_quiet, NULL, NULL, NULL, NULL};
+static role_t role_quiet = {.nprompts = MESSAGES_TYPES, .prompts = acts_quiet};
+
+static char *timers_deliver_until_cancelled()
+{
+    mu_assert("actor system create failed", run_system(&role) == 0);
+
+    mu_assert("periodic timer failed", timer >= 0);
+    mu_assert("cancelling failed", cancelled == 0);
+    mu_assert("ticks were handled after the timer was cancelled", ticks_after_cancel == 0);
+    mu_assert("one-shot timer was not delivered", late_msec >= 0);
+    /* Delays are counted in whole ticks of the wheel. */
+    mu_assert("one-shot timer fired early", late_msec >= LATE_MSEC - 1);
+    return 0;
+}
+
+/* Cancelling releases the message, and a periodic timer refuses one that
+ * cannot be shared between deliveries. */
+static char *timer_messages_are_released()
+{
+    actor_id_t actor;
+    mu_assert("actor system create failed", actor_system_create(&actor, &role_quiet) == 0);
+
+    message_t later = {.message_type = MSG_LATE, .release = release_counted};
+    timer_id_t later_timer = send_message_after(actor, later, LATER_MSEC);
+    mu_assert("timer failed", later_timer >= 0);
+    mu_assert("cancelling failed", cancel_timer(later_timer) == 0);
+    mu_assert("cancelled message was not released", atomic_load(&released) == 1);
+    mu_assert("cancelled twice", cancel_timer(later_timer) == -1);
+
+    message_t periodic = {.message_type = MSG_LATE, .release = release_counted};
+    mu_assert("periodic message without a reference count",
+              send_message_every(actor, periodic, LATER_MSEC) == -1);
+    mu_assert("refused periodic message was not released", atomic_load(&released) == 2);
+
+    send_go_die(actor);
+    actor_system_join(actor);
+    return 0;
+}
+
+static char *periodic_timer_does_not_pile_up()
+{
+    mu_assert("actor system create failed", run_system(&role_slow) == 0);
+
+    mu_assert("periodic timer failed", slow_timer >= 0);
+    mu_assert("stats failed", stats_err == 0);
+    printf(__FILE__ ": mailbox high water %llu\n", high_water);
+    mu_assert("ticks piled up in the mailbox", high_water <= BOUND);
+    mu_assert("ticks were handled after the timer was cancelled", slow_ticks == SLOW_TICKS);
+    mu_assert("one-shot timer was not delivered", atomic_load(&slow_late_seen));
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(timers_deliver_until_cancelled);
+    mu_run_test(timer_messages_are_released);
+    mu_run_test(periodic_timer_does_not_pile_up);
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include "fixture.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define MSG_PING 1
+#define MESSAGES_TYPES 2
+
+#define PINGS 10
+#define TRACE_PATH "test_trace.json"
+
+static role_t role_child;
+
+static actor_id_t child = -1;
+
+static void on_hello_root(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    spawn_child(&role_child);
+}
+
+/* Pings itself PINGS times before dying, and has the root die with it. */
+static void on_hello_child(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+
+    child = actor_id_self();
+
+    message_t ping = {.message_type = MSG_PING};
+    for (size_t i = 0; i < PINGS; i++) {
+        send_message(actor_id_self(), ping);
+    }
+
+    send_go_die((actor_id_t) data);
+}
+
+static size_t pinged;
+
+static void on_ping_child(void **stateptr, size_t nbytes, void *data)
+{
+    (void) stateptr;
+    (void) nbytes;
+    (void) data;
+
+    if (++pinged == PINGS) {
+        die_self();
+    }
+}
+
+static act_t acts_root[] = {on_hello_root, NULL};
+static role_t role_root = {.nprompts = MESSAGES_TYPES, .prompts = acts_root};
+
+static act_t acts_child[] = {on_hello_child, on_ping_child};
+static role_t role_child = {.nprompts = MESSAGES_TYPES, .prompts = acts_child};
+
+static char *read_trace(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char *contents = malloc((size_t) length + 1);
+    if (contents != NULL) {
+        contents[fread(contents, 1, (size_t) length, file)] = '\0';
+    }
+    fclose(file);
+
+    return contents;
+}
+
+static size_t occurrences(const char *contents, const char *needle)
+{
+    size_t count = 0;
+    for (const char *at = strstr(contents, needle); at != NULL;
+         at = strstr(at + 1, needle)) {
+        count++;
+    }
+
+    return count;
+}
+
+static char *trace_is_written_on_join()
+{
+    remove(TRACE_PATH);
+
+    actor_system_config_t config;
+    actor_system_config_default(&config);
+    config.workers = 2;
+    config.trace_path = TRACE_PATH;
+
+    actor_id_t root;
+    mu_assert("actor system create failed",
+              actor_system_create_config(&root, &role_root, &config) == 0);
+    actor_system_join(root);
+
+    char *trace = read_trace(TRACE_PATH);
+    mu_assert("trace was not written", trace != NULL);
+
+    char child_ping[128];
+    snprintf(child_ping, sizeof(child_ping),
+             "\"actor\":%ld,\"message_type\":%d}", child, MSG_PING);
+
+    bool complete = strncmp(trace, "{\"traceEvents\":[", 16) == 0
+                    && strstr(trace, "\n]}\n") != NULL;
+    size_t spawns = occurrences(trace, "\"name\":\"spawn\"");
+    size_t deaths = occurrences(trace, "\"name\":\"death\"");
+    size_t begins = occurrences(trace, "\"name\":\"dispatch\",\"ph\":\"B\"");
+    size_t ends = occurrences(trace, "\"name\":\"dispatch\",\"ph\":\"E\"");
+    size_t pings = occurrences(trace, child_ping);
+    free(trace);
+    remove(TRACE_PATH);
+
+    mu_assert("trace is not a complete JSON object", complete);
+    mu_assert("spawns were not traced", spawns == 2);
+    mu_assert("deaths were not traced", deaths == 2);
+    mu_assert("dispatches do not pair up", begins == ends);
+    /* Both hellos, the spawn, both MSG_GODIE and the pings. */
+    mu_assert("dispatches are missing", begins >= PINGS + 5);
+    /* A send, a dispatch begin and a dispatch end for every ping. */
+    mu_assert("pings of the child are missing", pings >= 3 * PINGS);
+    return 0;
+}
+
+static char *all_tests()
+{
+    mu_run_test(trace_is_written_on_join);
+    return 0;
+}